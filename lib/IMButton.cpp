@@ -8,14 +8,15 @@
 
 using namespace sf;
 
-IMButton::IMButton() : normal_look(NULL), hover_look(NULL), pressed_look(NULL)
+IMButton::IMButton()
+    : normal_look(NULL_TEXTURE_HANDLE), hover_look(NULL_TEXTURE_HANDLE), pressed_look(NULL_TEXTURE_HANDLE)
 {
     _x_position = _y_position = 0;
     _x_dimension = _y_dimension = 100;
 }
 
 IMButton::IMButton( int x_pos, int y_pos, int x_size, int y_size )
-    : normal_look(NULL), hover_look(NULL), pressed_look(NULL)
+    : normal_look(NULL_TEXTURE_HANDLE), hover_look(NULL_TEXTURE_HANDLE), pressed_look(NULL_TEXTURE_HANDLE)
 { 
     setPosition( x_pos, y_pos );
     setSize( x_size, y_size );
@@ -120,31 +121,19 @@ int IMButton::doButton( int x_pos, int y_pos, int x_size, int y_size )
     if (uistate.active_widget == this)
     {
         // Pressed
-        Sprite *button = new Sprite( *pressed_look );
-        FloatRect frect = button->getGlobalBounds();
-        button->setPosition( x_pos, y_pos );
-        button->setScale( x_size / frect.width, y_size / frect.height );
-        IMGuiManager::getSingleton().pushSprite( button );
+        pushLook( pressed_look, x_pos, y_pos, x_size, y_size );
     }
     else
     {
         if (uistate.hot_widget == this)
         {
             // Hover
-            Sprite *button = new Sprite( *hover_look );
-            FloatRect frect = button->getGlobalBounds();
-            button->setPosition( x_pos, y_pos );
-            button->setScale( x_size / frect.width, y_size / frect.height );
-            IMGuiManager::getSingleton().pushSprite( button );
+            pushLook( hover_look, x_pos, y_pos, x_size, y_size );
         }
         else
         {
             // Normal
-            Sprite *button = new Sprite( *normal_look );
-            FloatRect frect = button->getGlobalBounds();
-            button->setPosition( x_pos, y_pos );
-            button->setScale( x_size / frect.width, y_size / frect.height );
-            IMGuiManager::getSingleton().pushSprite( button );
+            pushLook( normal_look, x_pos, y_pos, x_size, y_size );
         }
     }
 
@@ -154,17 +143,33 @@ int IMButton::doButton( int x_pos, int y_pos, int x_size, int y_size )
         return 0;
 }
 
-void IMButton::setNormalTexture( Texture* texture ) 
+void IMButton::pushLook( TextureHandle look, int x_pos, int y_pos, int x_size, int y_size )
+{
+    if (look == NULL_TEXTURE_HANDLE)
+        return; // Never given one
+
+    // A miss is reported by the manager, and the button just isn't drawn
+    TextureRegion region = SFML_TextureManager::getSingleton().getRegion( look );
+    if (region.texture == NULL)
+        return;
+
+    Sprite *button = new Sprite( *region.texture, region.rect );
+    button->setPosition( x_pos, y_pos );
+    button->setScale( float(x_size) / region.rect.width, float(y_size) / region.rect.height );
+    IMGuiManager::getSingleton().pushSprite( button );
+}
+
+void IMButton::setNormalTexture( TextureHandle texture ) 
 {
     normal_look = texture;
 }
 
-void IMButton::setHoverTexture( Texture* texture ) 
+void IMButton::setHoverTexture( TextureHandle texture ) 
 {
     hover_look = texture;
 }
 
-void IMButton::setPressedTexture( Texture* texture ) 
+void IMButton::setPressedTexture( TextureHandle texture ) 
 {
     pressed_look = texture;
 }
@@ -2,6 +2,7 @@
 #define IMGUI_BUTTON_HPP__
 
 #include "IMGuiWidget.hpp"
+#include "SFML_TextureManager.hpp"
 
 namespace sf { 
     class Texture; 
@@ -12,7 +13,11 @@ using namespace sf;
 class IMButton : public IMGuiWidget
 {
 protected:
-    Texture *normal_look, *hover_look, *pressed_look;
+    // Looked up every time the button's drawn, so they follow texture reloads
+    TextureHandle normal_look, hover_look, pressed_look;
+
+    // Queues a sprite of look stretched over the button
+    static void pushLook( TextureHandle look, int x_pos, int y_pos, int x_size, int y_size );
 
 public:
     IMButton();
@@ -21,7 +26,6 @@ public:
     IMButton( const IMButton& other );
     IMButton& operator=( const IMButton& rhs );
 
-    // NOTE: This DOES NOT delete the look Textures, they should be handled elsewhere
     virtual ~IMButton();
 
     ///////////////////////////////////////////////////////////////////////////
@@ -40,9 +44,10 @@ public:
     ///////////////////////////////////////////////////////////////////////////
     virtual int doButton( int x_pos, int y_pos, int x_size, int y_size );
 
-    void setNormalTexture( Texture *texture );
-    void setHoverTexture( Texture *texture );
-    void setPressedTexture( Texture *texture );
+    // Handles from SFML_TextureManager::internTexture
+    void setNormalTexture( TextureHandle texture );
+    void setHoverTexture( TextureHandle texture );
+    void setPressedTexture( TextureHandle texture );
 
     /* Put this in IMTextButton
     int setFont( Font& font );
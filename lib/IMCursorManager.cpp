@@ -142,6 +142,38 @@ bool IMCursorManager::createCursor( const CursorType type, const sf::Texture* te
     return createCursor( type, texture, 0, 0 );
 }
 
+bool IMCursorManager::createCursor( const CursorType type, const TextureRegion& region,
+        const int offset_x, const int offset_y, const int size_x, const int size_y )
+{
+    if (NULL == region.texture)
+        return false;
+
+    if (type == NONE || type == SYSTEM)
+        return false;
+
+    sf::Sprite* cursorSprite = new sf::Sprite( *region.texture, region.rect );
+    cursorSprite->setPosition( offset_x, offset_y );
+    cursorSprite->setScale( float(size_x) / region.rect.width, float(size_y) / region.rect.height );
+
+    loadSprite( type, cursorSprite );
+    return true;
+}
+
+bool IMCursorManager::createCursor( const CursorType type, const TextureRegion& region, const int offset_x, const int offset_y )
+{
+    if (NULL == region.texture)
+        return false;
+
+    if (type == NONE || type == SYSTEM)
+        return false;
+
+    sf::Sprite* cursorSprite = new sf::Sprite( *region.texture, region.rect );
+    cursorSprite->setPosition( offset_x, offset_y );
+
+    loadSprite( type, cursorSprite );
+    return true;
+}
+
 void IMCursorManager::loadSprite( CursorType type, sf::Sprite* sprite )
 {
     sf::Sprite*& old_sprite = m_cursor_images[type];
@@ -4,6 +4,8 @@
 #include <SFML/Graphics.hpp>
 #include <SFML/Window.hpp>
 
+#include "SFML_TextureManager.hpp"
+
 #include <vector>
 
 using namespace std;
@@ -71,6 +73,11 @@ public:
     bool createCursor( const CursorType type, const sf::Texture* texture, const sf::Vector2i offset );
     bool createCursor( const CursorType type, const sf::Texture* texture );
 
+    // For images packed into an atlas, see SFML_TextureManager::getRegion
+    bool createCursor( const CursorType type, const TextureRegion& region,
+            const int offset_x, const int offset_y, const int size_x, const int size_y );
+    bool createCursor( const CursorType type, const TextureRegion& region, const int offset_x, const int offset_y );
+
 private:
     void loadSprite( CursorType type, sf::Sprite* sprite );
 };
@@ -2,13 +2,18 @@
 
 #include "IMGuiManager.hpp"
 
-IMImageButton::IMImageButton() : IMButton()
+IMImageButton::IMImageButton() : IMButton(),
+      image_texture(NULL_TEXTURE_HANDLE),
+      _x_image_offset(0),
+      _y_image_offset(0),
+      _x_image_scale(1.0),
+      _y_image_scale(1.0)
 {
 }
 
 IMImageButton::IMImageButton( int x_pos, int y_pos, int x_size, int y_size )
     : IMButton( x_pos, y_pos, x_size, y_size ),
-      image_texture(NULL),
+      image_texture(NULL_TEXTURE_HANDLE),
       _x_image_offset(0),
       _y_image_offset(0),
       _x_image_scale(1.0),
@@ -18,7 +23,7 @@ IMImageButton::IMImageButton( int x_pos, int y_pos, int x_size, int y_size )
 
 IMImageButton::IMImageButton( const IMButton& other )
     : IMButton( other ),
-      image_texture(NULL),
+      image_texture(NULL_TEXTURE_HANDLE),
       _x_image_offset(0),
       _y_image_offset(0),
       _x_image_scale(1.0),
@@ -29,7 +34,7 @@ IMImageButton::IMImageButton( const IMButton& other )
 IMImageButton& IMImageButton::operator=( const IMButton& rhs )
 {
     IMButton::operator=( rhs );
-    image_texture = NULL;
+    image_texture = NULL_TEXTURE_HANDLE;
     _x_image_offset = 0;
     _y_image_offset = 0;
     _x_image_scale = 1.0;
@@ -58,8 +63,11 @@ int IMImageButton::doButton( int x_pos, int y_pos, int x_size, int y_size )
     // Render
 
     // Draw the image first (on top)
-    if (image_texture) {
-       Sprite *image = new Sprite( *image_texture );
+    TextureRegion image_region;
+    if (image_texture != NULL_TEXTURE_HANDLE)
+       image_region = SFML_TextureManager::getSingleton().getRegion( image_texture );
+    if (image_region.texture) {
+       Sprite *image = new Sprite( *image_region.texture, image_region.rect );
        image->setPosition( x_pos + _x_image_offset , y_pos + _y_image_offset );
        image->setScale( _x_image_scale, _y_image_scale );
        IMGuiManager::getSingleton().pushSprite( image );
@@ -68,31 +76,19 @@ int IMImageButton::doButton( int x_pos, int y_pos, int x_size, int y_size )
     if (uistate.active_widget == this)
     {
         // Pressed
-        Sprite *button = new Sprite( *pressed_look );
-        FloatRect frect = button->getGlobalBounds();
-        button->setPosition( x_pos, y_pos );
-        button->setScale( x_size / frect.width, y_size / frect.height );
-        IMGuiManager::getSingleton().pushSprite( button );
+        pushLook( pressed_look, x_pos, y_pos, x_size, y_size );
     }
     else
     {
         if (uistate.hot_widget == this)
         {
             // Hover
-            Sprite *button = new Sprite( *hover_look );
-            FloatRect frect = button->getGlobalBounds();
-            button->setPosition( x_pos, y_pos );
-            button->setScale( x_size / frect.width, y_size / frect.height );
-            IMGuiManager::getSingleton().pushSprite( button );
+            pushLook( hover_look, x_pos, y_pos, x_size, y_size );
         }
         else
         {
             // Normal
-            Sprite *button = new Sprite( *normal_look );
-            FloatRect frect = button->getGlobalBounds();
-            button->setPosition( x_pos, y_pos );
-            button->setScale( x_size / frect.width, y_size / frect.height );
-            IMGuiManager::getSingleton().pushSprite( button );
+            pushLook( normal_look, x_pos, y_pos, x_size, y_size );
         }
     }
 
@@ -103,7 +99,7 @@ int IMImageButton::doButton( int x_pos, int y_pos, int x_size, int y_size )
 
 }
 
-void IMImageButton::setImage( Texture *texture )
+void IMImageButton::setImage( TextureHandle texture )
 {
     image_texture = texture;
 }
@@ -116,11 +112,13 @@ void IMImageButton::setImageOffset( int x_off, int y_off )
 
 int IMImageButton::setImageSize( int x_size, int y_size )
 {
-   if (image_texture) {
-      Vector2u t_size = image_texture->getSize();
+   if (image_texture == NULL_TEXTURE_HANDLE)
+      return -1;
 
-      _x_image_scale = ((float)x_size) / t_size.x;
-      _y_image_scale = ((float)y_size) / t_size.y;
+   TextureRegion image_region = SFML_TextureManager::getSingleton().getRegion( image_texture );
+   if (image_region.texture) {
+      _x_image_scale = ((float)x_size) / image_region.rect.width;
+      _y_image_scale = ((float)y_size) / image_region.rect.height;
       return 0;
    }
    return -1;
@@ -27,12 +27,12 @@ public:
     virtual int doButton( int x_pos, int y_pos, int x_size, int y_size );
 
 // New functionality
-    void setImage( sf::Texture *texture );
-    int setImageSize( int x_size, int y_size ); // Fails if there is no texture
+    void setImage( TextureHandle texture ); // From SFML_TextureManager::internTexture
+    int setImageSize( int x_size, int y_size ); // Fails if the texture isn't loaded
     void setImageOffset( int x_off, int y_off );
 
 protected:
-    sf::Texture* image_texture;
+    TextureHandle image_texture;
     int _x_image_offset, _y_image_offset;
     float _x_image_scale, _y_image_scale;
 };
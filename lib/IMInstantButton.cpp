@@ -45,31 +45,19 @@ int IMInstantButton::doButton( int x_pos, int y_pos, int x_size, int y_size )
     if (uistate.active_widget == this)
     {
         // Pressed
-        Sprite *button = new Sprite( *pressed_look );
-        FloatRect frect = button->getGlobalBounds();
-        button->setPosition( x_pos, y_pos );
-        button->setScale( x_size / frect.width, y_size / frect.height );
-        IMGuiManager::getSingleton().pushSprite( button );
+        pushLook( pressed_look, x_pos, y_pos, x_size, y_size );
     }
     else
     {
         if (uistate.hot_widget == this)
         {
             // Hover
-            Sprite *button = new Sprite( *hover_look );
-            FloatRect frect = button->getGlobalBounds();
-            button->setPosition( x_pos, y_pos );
-            button->setScale( x_size / frect.width, y_size / frect.height );
-            IMGuiManager::getSingleton().pushSprite( button );
+            pushLook( hover_look, x_pos, y_pos, x_size, y_size );
         }
         else
         {
             // Normal
-            Sprite *button = new Sprite( *normal_look );
-            FloatRect frect = button->getGlobalBounds();
-            button->setPosition( x_pos, y_pos );
-            button->setScale( x_size / frect.width, y_size / frect.height );
-            IMGuiManager::getSingleton().pushSprite( button );
+            pushLook( normal_look, x_pos, y_pos, x_size, y_size );
         }
     }
 
@@ -39,4 +39,12 @@ public:
     virtual bool windowGainedFocus( ) = 0;
 };
 
+/* Gets every event polled in a frame in one call, after the other listeners
+ * have seen them.  The events are only valid during the call. */
+class My_SFML_BatchListener
+{
+public:
+    virtual void eventBatch( const sf::Event *events, unsigned int count ) = 0;
+};
+
 #endif
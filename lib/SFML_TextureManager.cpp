@@ -1,10 +1,23 @@
 #include "SFML_TextureManager.hpp"
 
 #include <SFML/Graphics/Texture.hpp>
+#include <SFML/Graphics/Image.hpp>
+
+#include <algorithm>
+#include <sstream>
+
+// Gap left between packed images so filtering doesn't bleed between them
+static const unsigned int atlas_padding = 1;
 
 SFML_TextureManager::SFML_TextureManager()
 {
     path_list.push_back("./"); // Default search directory
+
+    atlas_mode = false;
+    atlas_size = 1024;
+    row_x = row_y = row_height = 0;
+
+    miss_reporter = NULL;
 }
 
 SFML_TextureManager::~SFML_TextureManager()
@@ -18,7 +31,7 @@ SFML_TextureManager& SFML_TextureManager::getSingleton()
     return singleton;
 }
 
-void SFML_TextureManager::addSearchDirectory( string dir )
+void SFML_TextureManager::addSearchDirectory( const string& dir )
 { 
     path_list.push_front( dir );
 }
@@ -29,11 +42,11 @@ void SFML_TextureManager::clearSearchDirectories()
     path_list.push_back("./");
 }
 
-bool SFML_TextureManager::addTexture( string path )
+// Works for anything with loadFromFile( string ), i.e. Texture and Image
+template <class T>
+static bool loadFromSearchPath( const deque<string>& path_list, const string& path, T& resource )
 {
-    Texture* texture = new Texture();
-    bool success = false;
-    for ( deque<string>::iterator it = path_list.begin();
+    for ( deque<string>::const_iterator it = path_list.begin();
             it != path_list.end();
             ++it )
     {
@@ -41,15 +54,28 @@ bool SFML_TextureManager::addTexture( string path )
         string full_path( *it );
         full_path.append( path );
 
-        if ( texture->loadFromFile( full_path ) )
+        if ( resource.loadFromFile( full_path ) )
+            return true; // Success!
+    }
+    return false;
+}
+
+bool SFML_TextureManager::addTexture( const string& path )
+{
+    if (atlas_mode)
+    {
+        // Just load it, buildAtlases() does the rest
+        Image* image = new Image();
+        if ( !loadFromSearchPath( path_list, path, *image ) )
         {
-            // Success!
-            success = true;
-            break; 
+            delete image;
+            return false;
         }
+        return addImage( path, image );
     }
 
-    if (success)
+    Texture* texture = new Texture();
+    if ( loadFromSearchPath( path_list, path, *texture ) )
     {
         // If there's already a texture for this string, we delete it
         map<string, Texture*>::iterator it = texture_map.find( path );
@@ -60,6 +86,7 @@ bool SFML_TextureManager::addTexture( string path )
         }
 
         texture_map[path] = texture;
+        refreshHandle( path );
         return true;
     }
     else
@@ -70,7 +97,7 @@ bool SFML_TextureManager::addTexture( string path )
     }
 }
 
-bool SFML_TextureManager::addTexture( string internal_path, Texture* texture )
+bool SFML_TextureManager::addTexture( const string& internal_path, Texture* texture )
 {
     if (texture == NULL) {
         return false;
@@ -86,33 +113,184 @@ bool SFML_TextureManager::addTexture( string internal_path, Texture* texture )
         }
 
         texture_map[internal_path] = texture;
+        refreshHandle( internal_path );
+        return true;
+    }
+}
+
+bool SFML_TextureManager::addImage( const string& path, Image* image )
+{
+    if (image == NULL)
+        return false;
+
+    if (atlas_mode)
+    {
+        map<string, Image*>::iterator it = pending_images.find( path );
+        if (it != pending_images.end())
+            delete (it->second);
+
+        pending_images[path] = image;
+        refreshHandle( path );
         return true;
     }
+
+    Texture* texture = new Texture();
+    bool made = texture->loadFromImage( *image );
+    delete image;
+    if (!made)
+    {
+        delete texture;
+        return false;
+    }
+    return addTexture( path, texture );
 }
 
-Texture* SFML_TextureManager::getTexture( string path )
+Texture* SFML_TextureManager::getTexture( const string& path )
 {
     map<string, Texture*>::iterator it = texture_map.find( path );
     if ( it != texture_map.end() ) {
         // Found it
         return it->second;
     }
-    else
+
+    if (atlas_mode)
+        return getRegion( path ).texture;
+
+    // Loading is addTexture's job, this may be mid-frame
+    reportMiss( internTexture( path ) );
+    return NULL;
+}
+
+//////////////////////////////////////////////////////////////////////
+// Atlases
+//////////////////////////////////////////////////////////////////////
+
+void SFML_TextureManager::setAtlasMode( bool on, unsigned int size )
+{
+    atlas_mode = on;
+
+    unsigned int max_size = Texture::getMaximumSize();
+    atlas_size = (size > max_size) ? max_size : size;
+}
+
+bool SFML_TextureManager::packImage( const string& path, const Image& image )
+{
+    const unsigned int w = image.getSize().x, h = image.getSize().y;
+
+    TextureRegion region;
+
+    if (w > atlas_size || h > atlas_size)
     {
-        // Attempt to create it
-        if ( addTexture( path ) )
-        {
-            return texture_map[path];
+        // Too big to share, give it its own
+        Texture* texture = new Texture();
+        if ( !texture->loadFromImage( image ) ) {
+            delete texture;
+            return false;
         }
-        else
-        {
-            return NULL; // No good
+
+        addTexture( path, texture );
+        region.texture = texture;
+        region.rect = IntRect( 0, 0, w, h );
+        region_map[path] = region;
+        refreshHandle( path );
+        return true;
+    }
+
+    // Next row, and next page if that row won't fit either
+    if (row_x + w > atlas_size) {
+        row_y += row_height + atlas_padding;
+        row_x = 0;
+        row_height = 0;
+    }
+    if (atlas_pages.empty() || row_y + h > atlas_size) {
+        Texture* page = new Texture();
+        if ( !page->create( atlas_size, atlas_size ) ) {
+            delete page;
+            return false;
         }
+        atlas_pages.push_back( page );
+        row_x = row_y = row_height = 0;
     }
+
+    Texture* page = atlas_pages.back();
+    page->update( image, row_x, row_y );
+
+    region.texture = page;
+    region.rect = IntRect( row_x, row_y, w, h );
+    region_map[path] = region;
+    refreshHandle( path );
+
+    row_x += w + atlas_padding;
+    if (h > row_height)
+        row_height = h;
+
+    return true;
 }
 
-bool SFML_TextureManager::clearTexture( string path )
+typedef pair<string, Image*> PendingImage;
+
+static bool tallerFirst( const PendingImage& a, const PendingImage& b )
 {
+    return a.second->getSize().y > b.second->getSize().y;
+}
+
+bool SFML_TextureManager::buildAtlases()
+{
+    // Rows waste least when each holds images of about the same height
+    vector<PendingImage> images( pending_images.begin(), pending_images.end() );
+    stable_sort( images.begin(), images.end(), tallerFirst );
+
+    bool success = true;
+    for (unsigned int i = 0; i < images.size(); ++i) {
+        if ( !packImage( images[i].first, *images[i].second ) )
+            success = false;
+        delete images[i].second;
+    }
+    pending_images.clear();
+
+    return success;
+}
+
+TextureRegion SFML_TextureManager::getRegion( const string& path )
+{
+    map<string, TextureRegion>::iterator it = region_map.find( path );
+    if ( it != region_map.end() )
+        return it->second;
+
+    map<string, Texture*>::iterator texture = texture_map.find( path );
+    if ( texture != texture_map.end() && texture->second != NULL )
+    {
+        // The whole of an ordinary texture
+        TextureRegion region;
+        region.texture = texture->second;
+        region.rect = IntRect( 0, 0, region.texture->getSize().x, region.texture->getSize().y );
+        return region;
+    }
+
+    // Including images not packed yet, like the handle lookup
+    reportMiss( internTexture( path ) );
+    return TextureRegion();
+}
+
+bool SFML_TextureManager::clearTexture( const string& path )
+{
+    bool found = clearTextureEntries( path );
+    refreshHandle( path );
+    return found;
+}
+
+bool SFML_TextureManager::clearTextureEntries( const string& path )
+{
+    // A packed image's space isn't reclaimed, but it can't be looked up any more
+    bool found = (region_map.erase( path ) > 0);
+
+    map<string, Image*>::iterator pending = pending_images.find( path );
+    if ( pending != pending_images.end() ) {
+        delete (pending->second);
+        pending_images.erase( pending );
+        found = true;
+    }
+
     map<string, Texture*>::iterator it = texture_map.find( path );
     if ( it != texture_map.end() ) {
         // Texture exists, clear it
@@ -121,7 +299,7 @@ bool SFML_TextureManager::clearTexture( string path )
         texture_map.erase(it);
         return true;
     }
-    return false;
+    return found;
 }
 
 void SFML_TextureManager::clearAllTextures()
@@ -134,4 +312,112 @@ void SFML_TextureManager::clearAllTextures()
         ++it;
     }
     texture_map.clear();
-} 
+
+    for (unsigned int i = 0; i < atlas_pages.size(); ++i)
+        delete atlas_pages[i];
+    atlas_pages.clear();
+    row_x = row_y = row_height = 0;
+
+    map<string, Image*>::iterator pending = pending_images.begin();
+    while ( pending != pending_images.end() ) {
+        delete (pending->second);
+        ++pending;
+    }
+    pending_images.clear();
+
+    region_map.clear();
+
+    refreshAllHandles();
+}
+
+//////////////////////////////////////////////////////////////////////
+// Handles
+//////////////////////////////////////////////////////////////////////
+
+TextureHandle SFML_TextureManager::internTexture( const string& path )
+{
+    map<string, TextureHandle>::iterator it = handle_map.find( path );
+    if ( it != handle_map.end() )
+        return it->second;
+
+    if (handle_slots.empty())
+        handle_slots.resize( 1 ); // NULL_TEXTURE_HANDLE
+
+    TextureHandle handle = handle_slots.size();
+    HandleSlot slot;
+    slot.path = path;
+    slot.miss_reported = false;
+    handle_slots.push_back( slot );
+    handle_map[path] = handle;
+
+    refreshHandle( path );
+    return handle;
+}
+
+void SFML_TextureManager::refreshHandle( const string& path )
+{
+    map<string, TextureHandle>::iterator it = handle_map.find( path );
+    if ( it == handle_map.end() )
+        return;
+
+    HandleSlot& slot = handle_slots[it->second];
+    slot.region = TextureRegion();
+    slot.miss_reported = false;
+
+    // Images still waiting for buildAtlases() have nothing to point at yet
+    map<string, TextureRegion>::iterator region = region_map.find( path );
+    if ( region != region_map.end() ) {
+        slot.region = region->second;
+        return;
+    }
+
+    map<string, Texture*>::iterator texture = texture_map.find( path );
+    if ( texture != texture_map.end() && texture->second != NULL ) {
+        slot.region.texture = texture->second;
+        slot.region.rect = IntRect( 0, 0, texture->second->getSize().x, texture->second->getSize().y );
+    }
+}
+
+void SFML_TextureManager::refreshAllHandles()
+{
+    for (unsigned int i = 1; i < handle_slots.size(); ++i)
+        refreshHandle( handle_slots[i].path );
+}
+
+void SFML_TextureManager::setMissReporter( TextureMissReporter reporter )
+{
+    miss_reporter = reporter;
+}
+
+void SFML_TextureManager::reportMiss( TextureHandle handle )
+{
+    if (miss_reporter == NULL)
+        return;
+
+    if (handle == NULL_TEXTURE_HANDLE || handle >= handle_slots.size()) {
+        ostringstream message;
+        message << "SFML_TextureManager: bad texture handle " << handle;
+        miss_reporter( message.str() );
+        return;
+    }
+
+    HandleSlot& slot = handle_slots[handle];
+    if (!slot.miss_reported) {
+        miss_reporter( "SFML_TextureManager: texture not loaded: " + slot.path );
+        slot.miss_reported = true;
+    }
+}
+
+Texture* SFML_TextureManager::getTexture( TextureHandle handle )
+{
+    return getRegion( handle ).texture;
+}
+
+TextureRegion SFML_TextureManager::getRegion( TextureHandle handle )
+{
+    if (handle < handle_slots.size() && handle_slots[handle].region.texture != NULL)
+        return handle_slots[handle].region;
+
+    reportMiss( handle );
+    return TextureRegion();
+}
@@ -13,56 +13,149 @@
  * your code much more flexible.
  * Add these in the order you expect them to be searched.
  *
- * Second, call addTexture( string path ), or getTexture( ... ) which will call
- * addTexture if the texture isn't there.  Do this for any textures you will need
- * during run time, BEFORE run time comes around, to avoid slowdown.
+ * Second, call addTexture( string path ) for any textures you will need during
+ * run time, BEFORE run time comes around.  Nothing else loads from disk.
  *
  * Alternatively, call addTexture( string internal_path, Texture* texture ) to add
- * textures that were generated programatically.
+ * textures that were generated programatically, or addImage( path, Image* ) to
+ * hand over an image that was decoded elsewhere, e.g. on a loading thread.
  *
- * Third, when a Texture is needed, call getTexture( string path ) to retrieve it.
+ * Third, when a Texture is needed, call getTexture( string path ) to retrieve it,
+ * or better, use a handle (see below).
  *
  * That is all the steps.  Textures will be deleted at program end
  * (when the SFML_TextureManager singleton is deleted),
  * or they can be cleared with clearAllTextures() or clearTexture( string path )
  * if you want to cut down on memory usage.
+ *
+ * Atlas mode:
+ * Call setAtlasMode( true ) before adding anything.  addTexture( path ) then only
+ * loads the image, and buildAtlases() packs everything loaded so far into a few
+ * large atlas textures, tallest images first, in rows.  getRegion( path ) gives
+ * the atlas texture and the rectangle the image ended up in; getTexture( path )
+ * gives just the atlas texture, so use getRegion for anything drawn from it.
+ * Sprites drawn from the same atlas share a texture and can be drawn without
+ * rebinding.  Anything added after buildAtlases() isn't there until the next
+ * call packs it into the space left; lookups never pack, since that means
+ * uploading to the card mid-frame.  Replacing a packed image packs the new
+ * one and leaves the old one's space unused.  Images too big for an atlas get a texture of their own,
+ * and textures added directly as Texture* are never packed.
+ *
+ * Handles:
+ * getTexture( string path ) compares strings, which is fine at load time but
+ * not every frame.  Instead call internTexture( path ) once, keep the
+ * TextureHandle it returns, and look that up at run time: it's an array index.
+ * A handle follows its path, so it sees textures added, replaced, packed or
+ * cleared after it was made.  In atlas mode a handle doesn't see images not
+ * yet packed, so call buildAtlases() once loading is done.
+ *
+ * Misses:
+ * Looking up a path or handle whose texture isn't there gives NULL.  It's
+ * reported once per path, through whatever was given to setMissReporter(),
+ * and never by loading the file or writing to a stream mid-frame.
  */
 
 #include <map>
 #include <deque>
+#include <vector>
 #include <string>
 
+#include <SFML/Graphics/Rect.hpp>
+
 // Forward declarations
 namespace sf { 
     class Texture; 
+    class Image;
 };
 
 using namespace std;
 using namespace sf;
 
+// A texture and the part of it an image occupies
+struct TextureRegion
+{
+    Texture *texture; // NULL if there's no such image
+    IntRect rect;
+
+    TextureRegion() { texture = NULL; }
+};
+
+// Index into the manager's handle table; 0 is never a texture
+typedef unsigned int TextureHandle;
+#define NULL_TEXTURE_HANDLE 0
+
+typedef void (*TextureMissReporter)( const string& message );
+
 // Class
 class SFML_TextureManager
 {
     map<string, Texture*> texture_map;
     deque<string> path_list;
 
+    // Atlas mode
+    bool atlas_mode;
+    unsigned int atlas_size;
+    vector<Texture*> atlas_pages;
+    map<string, TextureRegion> region_map;
+    map<string, Image*> pending_images; // Loaded, not yet packed
+    // Packing position in the last page: rows are filled left to right
+    unsigned int row_x, row_y, row_height;
+
+    // Handles
+    struct HandleSlot
+    {
+        string path;
+        TextureRegion region;
+        bool miss_reported;
+    };
+    map<string, TextureHandle> handle_map; // Only used when interning
+    vector<HandleSlot> handle_slots;       // Indexed by TextureHandle
+    TextureMissReporter miss_reporter;
+
+    // Points path's handle, if it has one, at whatever path now names
+    void refreshHandle( const string& path );
+    void refreshAllHandles();
+    void reportMiss( TextureHandle handle );
+
+    bool clearTextureEntries( const string& path );
+
     SFML_TextureManager();
     ~SFML_TextureManager();
 
+    bool packImage( const string& path, const Image& image );
+
 public:
     static SFML_TextureManager& getSingleton();
 
-    void addSearchDirectory( string dir );
+    void addSearchDirectory( const string& dir );
     void clearSearchDirectories();
 
     // Returns false if file can't be found
-    bool addTexture( string path );
+    bool addTexture( const string& path );
     // Returns false if passed Texture* is null
-    bool addTexture( string internal_path, Texture* texture );
+    bool addTexture( const string& internal_path, Texture* texture );
+    // Takes ownership of image.  In atlas mode it waits for buildAtlases(),
+    // otherwise it's made into a texture now.  False if image is null or
+    // the texture can't be made.
+    bool addImage( const string& path, Image* image );
+
+    Texture* getTexture( const string& path );
+
+    // Always succeeds; the same path always gives the same handle
+    TextureHandle internTexture( const string& path );
+    // NULL, the default, keeps misses quiet
+    void setMissReporter( TextureMissReporter reporter );
+    Texture* getTexture( TextureHandle handle );
+    TextureRegion getRegion( TextureHandle handle );
 
-    Texture* getTexture( string path );
+    // size is the width and height of each atlas texture, clamped to what the card allows
+    void setAtlasMode( bool on, unsigned int size = 1024 );
+    // Packs every image added since the last call; false if any couldn't be packed
+    bool buildAtlases();
+    // Images still waiting for buildAtlases() are a miss
+    TextureRegion getRegion( const string& path );
 
-    bool clearTexture( string path );
+    bool clearTexture( const string& path );
     void clearAllTextures();
 };
 #endif
@@ -6,10 +6,8 @@
 #include <SFML/Graphics/RenderWindow.hpp>
 
 #include <set>
-#include <map>
 #include <string>
- 
-#include <iostream>
+#include <vector>
 
 SFML_WindowEventManager::SFML_WindowEventManager( void )
 { }
@@ -61,59 +59,160 @@ sf::RenderWindow* SFML_WindowEventManager::getRenderWindow() {
     return SFML_GlobalRenderWindow::get();
 }
  
+template <class T>
+static void addListener( std::vector< SFML_ListenerEntry<T> > &list, T *listener,
+                         const std::string &name, int priority, unsigned int mask )
+{
+    // Check for duplicate items
+    for( size_t i = 0; i < list.size(); ++i ) {
+        if( list[i].name == name )
+            return;
+    }
+
+    SFML_ListenerEntry<T> entry;
+    entry.listener = listener;
+    entry.name = name;
+    entry.priority = priority;
+    entry.mask = mask;
+
+    // After everything of the same or higher priority
+    typename std::vector< SFML_ListenerEntry<T> >::iterator it = list.begin();
+    while( it != list.end() && it->priority >= priority )
+        ++it;
+    list.insert( it, entry );
+}
+
+template <class T>
+static void removeListener( std::vector< SFML_ListenerEntry<T> > &list, const std::string &name )
+{
+    for( size_t i = 0; i < list.size(); ++i ) {
+        if( list[i].name == name ) {
+            list.erase( list.begin() + i );
+            return;
+        }
+    }
+}
+
+template <class T>
+static void removeListener( std::vector< SFML_ListenerEntry<T> > &list, T *listener )
+{
+    for( size_t i = 0; i < list.size(); ++i ) {
+        if( list[i].listener == listener ) {
+            list.erase( list.begin() + i );
+            return;
+        }
+    }
+}
+
+template <class T, class E>
+static void dispatch( const std::vector< SFML_ListenerEntry<T> > &list, sf::Event::EventType type,
+                      bool (T::*handler)( const E& ), const E &e )
+{
+    const unsigned int bit = SFML_EVENT_MASK( type );
+    for( size_t i = 0; i < list.size(); ++i ) {
+        const SFML_ListenerEntry<T> &entry = list[i];
+        if( (entry.mask & bit) && !(entry.listener->*handler)( e ) )
+            break;
+    }
+}
+
+template <class T>
+static void dispatch( const std::vector< SFML_ListenerEntry<T> > &list, sf::Event::EventType type,
+                      bool (T::*handler)( ) )
+{
+    const unsigned int bit = SFML_EVENT_MASK( type );
+    for( size_t i = 0; i < list.size(); ++i ) {
+        const SFML_ListenerEntry<T> &entry = list[i];
+        if( (entry.mask & bit) && !(entry.listener->*handler)( ) )
+            break;
+    }
+}
+
 bool SFML_WindowEventManager::handleEvents( void ) {
     sf::RenderWindow* r_window = getRenderWindow();
     if (!r_window)
         return false;
 
+    const bool batching = !mBatchListeners.empty();
+    mFrameEvents.clear();
+
     sf::Event event;
     while ( r_window->pollEvent(event) )
     {
+        if (batching)
+            mFrameEvents.push_back( event );
+
         switch (event.type) {
             case sf::Event::KeyPressed:
-                keyPressed( event.key );
+                dispatch( mKeyListeners, event.type, &My_SFML_KeyListener::keyPressed, event.key );
                 break;
 
             case sf::Event::KeyReleased:
-                keyReleased( event.key );
+                dispatch( mKeyListeners, event.type, &My_SFML_KeyListener::keyReleased, event.key );
                 break;
 
             case sf::Event::MouseMoved:
-                mouseMoved( event.mouseMove );
+                dispatch( mMouseListeners, event.type, &My_SFML_MouseListener::mouseMoved, event.mouseMove );
                 break;
 
             case sf::Event::MouseButtonPressed:
-                mouseButtonPressed( event.mouseButton );
+                dispatch( mMouseListeners, event.type, &My_SFML_MouseListener::mouseButtonPressed, event.mouseButton );
                 break;
 
             case sf::Event::MouseButtonReleased:
-                mouseButtonReleased( event.mouseButton );
+                dispatch( mMouseListeners, event.type, &My_SFML_MouseListener::mouseButtonReleased, event.mouseButton );
                 break;
 
             case sf::Event::MouseWheelMoved:
-                mouseWheelMoved( event.mouseWheel );
+                dispatch( mMouseListeners, event.type, &My_SFML_MouseListener::mouseWheelMoved, event.mouseWheel );
+                break;
+
+            case sf::Event::JoystickMoved:
+                dispatch( mJoystickListeners, event.type, &My_SFML_JoystickListener::joystickMoved, event.joystickMove );
+                break;
+
+            case sf::Event::JoystickButtonPressed:
+                dispatch( mJoystickListeners, event.type, &My_SFML_JoystickListener::joystickButtonPressed, event.joystickButton );
+                break;
+
+            case sf::Event::JoystickButtonReleased:
+                dispatch( mJoystickListeners, event.type, &My_SFML_JoystickListener::joystickButtonReleased, event.joystickButton );
+                break;
+
+            case sf::Event::JoystickConnected:
+                joystickConnected( event.joystickConnect );
+                break;
+
+            case sf::Event::JoystickDisconnected:
+                joystickDisconnected( event.joystickConnect );
                 break;
 
-            //case sf::Event::JoystickMoved: etc.
             case sf::Event::Closed:
-                windowClosed();
+                dispatch( mWindowListeners, event.type, &My_SFML_WindowListener::windowClosed );
                 break;
 
             case sf::Event::Resized:
-                windowResized( event.size );
+                dispatch( mWindowListeners, event.type, &My_SFML_WindowListener::windowResized, event.size );
                 break;
 
             case sf::Event::LostFocus:
-                windowLostFocus();
+                dispatch( mWindowListeners, event.type, &My_SFML_WindowListener::windowLostFocus );
                 break;
 
             case sf::Event::GainedFocus:
-                windowGainedFocus();
+                dispatch( mWindowListeners, event.type, &My_SFML_WindowListener::windowGainedFocus );
+                break;
+
+            default:
                 break;
-                // There are several other ones, so no default gives a warning at compile time.
         }
     }
 
+    if (batching && !mFrameEvents.empty()) {
+        for( size_t i = 0; i < mBatchListeners.size(); ++i )
+            mBatchListeners[i].listener->eventBatch( &mFrameEvents[0], mFrameEvents.size() );
+    }
+
     return true;
 
     /* Old stuff
@@ -136,139 +235,71 @@ bool SFML_WindowEventManager::handleEvents( void ) {
     */
 }
  
-void SFML_WindowEventManager::addKeyListener( My_SFML_KeyListener *keyListener, const std::string& instanceName ) {
-    // Check for duplicate items
-    itKeyListener = mKeyListeners.find( instanceName );
-    if( itKeyListener == mKeyListeners.end() ) {
-        mKeyListeners[ instanceName ] = keyListener;
-    }
-    else {
-        // Duplicate Item
-    }
+void SFML_WindowEventManager::addKeyListener( My_SFML_KeyListener *keyListener, const std::string& instanceName,
+                                              int priority, unsigned int mask ) {
+    addListener( mKeyListeners, keyListener, instanceName, priority, mask );
 }
  
-void SFML_WindowEventManager::addMouseListener( My_SFML_MouseListener *mouseListener, const std::string& instanceName ) {
-    // Check for duplicate items
-    itMouseListener = mMouseListeners.find( instanceName );
-    if( itMouseListener == mMouseListeners.end() ) {
-        mMouseListeners[ instanceName ] = mouseListener;
-    }
-    else {
-        // Duplicate Item
-    }
-    
+void SFML_WindowEventManager::addMouseListener( My_SFML_MouseListener *mouseListener, const std::string& instanceName,
+                                                int priority, unsigned int mask ) {
+    addListener( mMouseListeners, mouseListener, instanceName, priority, mask );
 }
  
-void SFML_WindowEventManager::addJoystickListener( My_SFML_JoystickListener *joystickListener, const std::string& instanceName ) {
+void SFML_WindowEventManager::addJoystickListener( My_SFML_JoystickListener *joystickListener, const std::string& instanceName,
+                                                   int priority, unsigned int mask ) {
     if( mJoystickIDs.size() > 0 ) {
-        // Check for duplicate items
-        itJoystickListener = mJoystickListeners.find( instanceName );
-        if( itJoystickListener == mJoystickListeners.end() ) {
-            mJoystickListeners[ instanceName ] = joystickListener;
-        }
-        else {
-            // Duplicate Item
-        }
+        addListener( mJoystickListeners, joystickListener, instanceName, priority, mask );
     }
 }
     
-void SFML_WindowEventManager::addWindowListener( My_SFML_WindowListener *windowListener, const std::string& instanceName )
-{
-    itWindowListener = mWindowListeners.find( instanceName );
-    if( itWindowListener == mWindowListeners.end() ) {
-        mWindowListeners[ instanceName ] = windowListener;
-    }
-    else {
-        // Duplicate Item
-    }
+void SFML_WindowEventManager::addWindowListener( My_SFML_WindowListener *windowListener, const std::string& instanceName,
+                                                 int priority, unsigned int mask ) {
+    addListener( mWindowListeners, windowListener, instanceName, priority, mask );
+}
+
+void SFML_WindowEventManager::addBatchListener( My_SFML_BatchListener *batchListener, const std::string& instanceName,
+                                                int priority ) {
+    addListener( mBatchListeners, batchListener, instanceName, priority, SFML_ALL_EVENTS );
 }
  
 void SFML_WindowEventManager::removeKeyListener( const std::string& instanceName ) {
-    // Check if item exists
-    itKeyListener = mKeyListeners.find( instanceName );
-    if( itKeyListener != mKeyListeners.end() ) {
-        mKeyListeners.erase( itKeyListener );
-    }
-    else {
-        // Doesn't Exist
-    }
+    removeListener( mKeyListeners, instanceName );
 }
  
 void SFML_WindowEventManager::removeMouseListener( const std::string& instanceName ) {
-    // Check if item exists
-    itMouseListener = mMouseListeners.find( instanceName );
-    if( itMouseListener != mMouseListeners.end() ) {
-        mMouseListeners.erase( itMouseListener );
-    }
-    else {
-        // Doesn't Exist
-    }
+    removeListener( mMouseListeners, instanceName );
 }
  
 void SFML_WindowEventManager::removeJoystickListener( const std::string& instanceName ) {
-    // Check if item exists
-    itJoystickListener = mJoystickListeners.find( instanceName );
-    if( itJoystickListener != mJoystickListeners.end() ) {
-        mJoystickListeners.erase( itJoystickListener );
-    }
-    else {
-        // Doesn't Exist
-    }
+    removeListener( mJoystickListeners, instanceName );
 }
 
 void SFML_WindowEventManager::removeWindowListener( const std::string& instanceName ) {
-    // Check if item exists
-    itWindowListener = mWindowListeners.find( instanceName );
-    if( itWindowListener != mWindowListeners.end() ) {
-        mWindowListeners.erase( itWindowListener );
-    }
-    else {
-        // Doesn't Exist
-    }
+    removeListener( mWindowListeners, instanceName );
+}
+
+void SFML_WindowEventManager::removeBatchListener( const std::string& instanceName ) {
+    removeListener( mBatchListeners, instanceName );
 }
  
 void SFML_WindowEventManager::removeKeyListener( My_SFML_KeyListener *keyListener ) {
-    itKeyListener = mKeyListeners.begin();
-    itKeyListenerEnd = mKeyListeners.end();
-    for(; itKeyListener != itKeyListenerEnd; ++itKeyListener ) {
-        if( itKeyListener->second == keyListener ) {
-            mKeyListeners.erase( itKeyListener );
-            break;
-        }
-    }
+    removeListener( mKeyListeners, keyListener );
 }
  
 void SFML_WindowEventManager::removeMouseListener( My_SFML_MouseListener *mouseListener ) {
-    itMouseListener = mMouseListeners.begin();
-    itMouseListenerEnd = mMouseListeners.end();
-    for(; itMouseListener != itMouseListenerEnd; ++itMouseListener ) {
-        if( itMouseListener->second == mouseListener ) {
-            mMouseListeners.erase( itMouseListener );
-            break;
-        }
-    }
+    removeListener( mMouseListeners, mouseListener );
 }
  
 void SFML_WindowEventManager::removeJoystickListener( My_SFML_JoystickListener *joystickListener ) {
-    itJoystickListener = mJoystickListeners.begin();
-    itJoystickListenerEnd = mJoystickListeners.end();
-    for(; itJoystickListener != itJoystickListenerEnd; ++itJoystickListener ) {
-        if( itJoystickListener->second == joystickListener ) {
-            mJoystickListeners.erase( itJoystickListener );
-            break;
-        }
-    }
+    removeListener( mJoystickListeners, joystickListener );
 }
 
 void SFML_WindowEventManager::removeWindowListener( My_SFML_WindowListener *windowListener ) {
-    itWindowListener = mWindowListeners.begin();
-    itWindowListener = mWindowListeners.end();
-    for(; itWindowListener != itWindowListenerEnd; ++itWindowListener ) {
-        if( itWindowListener->second == windowListener ) {
-            mWindowListeners.erase( itWindowListener );
-            break;
-        }
-    }
+    removeListener( mWindowListeners, windowListener );
+}
+
+void SFML_WindowEventManager::removeBatchListener( My_SFML_BatchListener *batchListener ) {
+    removeListener( mBatchListeners, batchListener );
 }
  
 void SFML_WindowEventManager::removeAllListeners( void ) {
@@ -276,6 +307,7 @@ void SFML_WindowEventManager::removeAllListeners( void ) {
     removeAllMouseListeners();
     removeAllJoystickListeners();
     removeAllWindowListeners();
+    removeAllBatchListeners();
 }
  
 void SFML_WindowEventManager::removeAllKeyListeners( void ) {
@@ -293,6 +325,10 @@ void SFML_WindowEventManager::removeAllJoystickListeners( void ) {
 void SFML_WindowEventManager::removeAllWindowListeners( void ) {
     mWindowListeners.clear();
 }
+
+void SFML_WindowEventManager::removeAllBatchListeners( void ) {
+    mBatchListeners.clear();
+}
  
 /*
 void SFML_WindowEventManager::setWindowExtents( int width, int height ) {
@@ -327,105 +363,6 @@ int SFML_WindowEventManager::getNumOfJoysticks( void ) {
     return mJoystickIDs.size();
 }
  
-bool SFML_WindowEventManager::keyPressed( const sf::Event::KeyEvent &e ) {
-    itKeyListener = mKeyListeners.begin();
-    itKeyListenerEnd = mKeyListeners.end();
-    for(; itKeyListener != itKeyListenerEnd; ++itKeyListener ) {
-        if(!itKeyListener->second->keyPressed( e ))
-            break;
-    }
- 
-    return true;
-}
- 
-bool SFML_WindowEventManager::keyReleased( const sf::Event::KeyEvent &e ) {
-    itKeyListener = mKeyListeners.begin();
-    itKeyListenerEnd = mKeyListeners.end();
-    for(; itKeyListener != itKeyListenerEnd; ++itKeyListener ) {
-        if(!itKeyListener->second->keyReleased( e ))
-            break;
-    }
- 
-    return true;
-}
- 
-bool SFML_WindowEventManager::mouseMoved( const sf::Event::MouseMoveEvent &e ) {
-    itMouseListener = mMouseListeners.begin();
-    itMouseListenerEnd = mMouseListeners.end();
-    for(; itMouseListener != itMouseListenerEnd; ++itMouseListener ) {
-        if(!itMouseListener->second->mouseMoved( e ))
-            break;
-    }
- 
-    return true;
-}
- 
-bool SFML_WindowEventManager::mouseButtonPressed( const sf::Event::MouseButtonEvent &e ) {
-    itMouseListener    = mMouseListeners.begin();
-    itMouseListenerEnd = mMouseListeners.end();
-    for(; itMouseListener != itMouseListenerEnd; ++itMouseListener ) {
-        if(!itMouseListener->second->mouseButtonPressed( e ))
-            break;
-    }
- 
-    return true;
-}
- 
-bool SFML_WindowEventManager::mouseButtonReleased( const sf::Event::MouseButtonEvent &e ) {
-    itMouseListener    = mMouseListeners.begin();
-    itMouseListenerEnd = mMouseListeners.end();
-    for(; itMouseListener != itMouseListenerEnd; ++itMouseListener ) {
-        if(!itMouseListener->second->mouseButtonReleased( e ))
-            break;
-    }
- 
-    return true;
-}
-
-bool SFML_WindowEventManager::mouseWheelMoved( const sf::Event::MouseWheelEvent &mouse_wheel_move ) {
-    itMouseListener    = mMouseListeners.begin();
-    itMouseListenerEnd = mMouseListeners.end();
-    for(; itMouseListener != itMouseListenerEnd; ++itMouseListener ) {
-        if(!itMouseListener->second->mouseWheelMoved( mouse_wheel_move ))
-            break;
-    }
- 
-    return true;
-}
- 
-bool SFML_WindowEventManager::joystickMoved( const sf::Event::JoystickMoveEvent &e ) {
-    itJoystickListener    = mJoystickListeners.begin();
-    itJoystickListenerEnd = mJoystickListeners.end();
-    for(; itJoystickListener != itJoystickListenerEnd; ++itJoystickListener ) {
-        if(!itJoystickListener->second->joystickMoved( e ))
-            break;
-    }
- 
-    return true;
-}
-
-bool SFML_WindowEventManager::joystickButtonPressed( const sf::Event::JoystickButtonEvent &e ) {
-    itJoystickListener    = mJoystickListeners.begin();
-    itJoystickListenerEnd = mJoystickListeners.end();
-    for(; itJoystickListener != itJoystickListenerEnd; ++itJoystickListener ) {
-        if(!itJoystickListener->second->joystickButtonPressed( e ))
-            break;
-    }
- 
-    return true;
-}
- 
-bool SFML_WindowEventManager::joystickButtonReleased( const sf::Event::JoystickButtonEvent &e ) {
-    itJoystickListener    = mJoystickListeners.begin();
-    itJoystickListenerEnd = mJoystickListeners.end();
-    for(; itJoystickListener != itJoystickListenerEnd; ++itJoystickListener ) {
-        if(!itJoystickListener->second->joystickButtonReleased( e ))
-            break;
-    }
- 
-    return true;
-}
- 
 bool SFML_WindowEventManager::joystickConnected( const sf::Event::JoystickConnectEvent &e ) {
     // This one is different, we don't pass it on, we use it to register a new joystick
 
@@ -442,57 +379,6 @@ bool SFML_WindowEventManager::joystickDisconnected( const sf::Event::JoystickCon
  
     return true;
 }
-
-bool SFML_WindowEventManager::windowClosed( )
-{
-    itWindowListener    = mWindowListeners.begin();
-    itWindowListenerEnd = mWindowListeners.end();
-    for(; itWindowListener != itWindowListenerEnd; ++itWindowListener ) {
-        if(!itWindowListener->second->windowClosed( ))
-            break;
-    }
- 
-    return true;
-}
-
-bool SFML_WindowEventManager::windowResized( const sf::Event::SizeEvent &resized )
-{
-    itWindowListener    = mWindowListeners.begin();
-    itWindowListenerEnd = mWindowListeners.end();
-    for(; itWindowListener != itWindowListenerEnd; ++itWindowListener ) {
-        if(!itWindowListener->second->windowResized( resized ))
-            break;
-    }
- 
-    return true;
-
-}
-
-bool SFML_WindowEventManager::windowLostFocus( )
-{
-    itWindowListener    = mWindowListeners.begin();
-    itWindowListenerEnd = mWindowListeners.end();
-    for(; itWindowListener != itWindowListenerEnd; ++itWindowListener ) {
-        if(!itWindowListener->second->windowLostFocus( ))
-            break;
-    }
- 
-    return true;
-
-}
-
-bool SFML_WindowEventManager::windowGainedFocus( )
-{
-    itWindowListener    = mWindowListeners.begin();
-    itWindowListenerEnd = mWindowListeners.end();
-    for(; itWindowListener != itWindowListenerEnd; ++itWindowListener ) {
-        if(!itWindowListener->second->windowGainedFocus( ))
-            break;
-    }
- 
-    return true;
-
-}
  
 SFML_WindowEventManager& SFML_WindowEventManager::getSingleton( void ) {
     static SFML_WindowEventManager singleton;
@@ -1,8 +1,9 @@
 #ifndef SFML_WindowEventManager_H__
 #define SFML_WindowEventManager_H__
  
-#include <map>
 #include <set>
+#include <string>
+#include <vector>
 
 #include "SFML_Listeners.hpp"
 
@@ -13,9 +14,27 @@ class My_SFML_KeyListener;
 class My_SFML_MouseListener;
 class My_SFML_JoystickListener;
 class My_SFML_WindowListener;
+class My_SFML_BatchListener;
 
 /* This class does not definitely support joysticks, because I have no need for them. */
 
+/* Listener masks: a listener only hears about the event types in its mask,
+ * e.g. SFML_EVENT_MASK( sf::Event::MouseButtonPressed ). */
+#define SFML_EVENT_MASK( type ) (1u << (type))
+#define SFML_ALL_EVENTS 0xFFFFFFFFu
+
+/* Listeners of each kind are kept in a flat vector, highest priority first
+ * (equal priorities in the order they were added).  As before, a listener
+ * returning false stops the event going any further down the list. */
+template <class T>
+struct SFML_ListenerEntry
+{
+    T *listener;
+    std::string name;
+    int priority;
+    unsigned int mask;
+};
+
 class SFML_WindowEventManager
 {
 public:
@@ -26,26 +45,35 @@ public:
 
     bool handleEvents( void );
  
-    void addKeyListener( My_SFML_KeyListener *keyListener, const std::string& instanceName );
-    void addMouseListener( My_SFML_MouseListener *mouseListener, const std::string& instanceName );
-    void addJoystickListener( My_SFML_JoystickListener *joystickListener, const std::string& instanceName );
-    void addWindowListener( My_SFML_WindowListener *windowListener, const std::string& instanceName );
+    void addKeyListener( My_SFML_KeyListener *keyListener, const std::string& instanceName,
+                         int priority = 0, unsigned int mask = SFML_ALL_EVENTS );
+    void addMouseListener( My_SFML_MouseListener *mouseListener, const std::string& instanceName,
+                           int priority = 0, unsigned int mask = SFML_ALL_EVENTS );
+    void addJoystickListener( My_SFML_JoystickListener *joystickListener, const std::string& instanceName,
+                              int priority = 0, unsigned int mask = SFML_ALL_EVENTS );
+    void addWindowListener( My_SFML_WindowListener *windowListener, const std::string& instanceName,
+                            int priority = 0, unsigned int mask = SFML_ALL_EVENTS );
+    void addBatchListener( My_SFML_BatchListener *batchListener, const std::string& instanceName,
+                           int priority = 0 );
  
     void removeKeyListener( const std::string& instanceName );
     void removeMouseListener( const std::string& instanceName );
     void removeJoystickListener( const std::string& instanceName );
     void removeWindowListener( const std::string& instanceName );
+    void removeBatchListener( const std::string& instanceName );
  
     void removeKeyListener( My_SFML_KeyListener *keyListener );
     void removeMouseListener( My_SFML_MouseListener *mouseListener );
     void removeJoystickListener( My_SFML_JoystickListener *joystickListener );
     void removeWindowListener( My_SFML_WindowListener *windowListener );
+    void removeBatchListener( My_SFML_BatchListener *batchListener );
  
     void removeAllListeners( void );
     void removeAllKeyListeners( void );
     void removeAllMouseListeners( void );
     void removeAllJoystickListeners( void );
     void removeAllWindowListeners( void );
+    void removeAllBatchListeners( void );
  
     /* As far as I know, this isn't needed in SFML
     void setWindowExtents( int width, int height );
@@ -59,24 +87,8 @@ private:
     SFML_WindowEventManager( const SFML_WindowEventManager& ) { }
     SFML_WindowEventManager & operator = ( const SFML_WindowEventManager& );
  
-    bool keyPressed( const sf::Event::KeyEvent &key_press );
-    bool keyReleased( const sf::Event::KeyEvent &key_release );
- 
-    bool mouseMoved( const sf::Event::MouseMoveEvent &mouse_move );
-    bool mouseButtonPressed( const sf::Event::MouseButtonEvent &mouse_button_press );
-    bool mouseButtonReleased( const sf::Event::MouseButtonEvent &mouse_button_release );
-    bool mouseWheelMoved( const sf::Event::MouseWheelEvent &mouse_wheel_move );
- 
-    bool joystickMoved( const sf::Event::JoystickMoveEvent &joystick_move );
-    bool joystickButtonPressed( const sf::Event::JoystickButtonEvent &joystick_button_pressed );
-    bool joystickButtonReleased( const sf::Event::JoystickButtonEvent &joystick_button_released );
     bool joystickConnected( const sf::Event::JoystickConnectEvent &joystick_connect );
     bool joystickDisconnected( const sf::Event::JoystickConnectEvent &joystick_disconnect );
- 
-    bool windowClosed( );
-    bool windowResized( const sf::Event::SizeEvent &resized );
-    bool windowLostFocus( );
-    bool windowGainedFocus( );
 
     /*
     OIS::Mouse        *mMouse;
@@ -85,22 +97,14 @@ private:
     */
  
     std::set<unsigned int> mJoystickIDs;
-    std::set<unsigned int>::iterator itJoystick;
-    std::set<unsigned int>::iterator itJoystickEnd;
- 
-    std::map<std::string, My_SFML_KeyListener*> mKeyListeners;
-    std::map<std::string, My_SFML_MouseListener*> mMouseListeners;
-    std::map<std::string, My_SFML_JoystickListener*> mJoystickListeners;
-    std::map<std::string, My_SFML_WindowListener*> mWindowListeners;
  
-    std::map<std::string, My_SFML_KeyListener*>::iterator itKeyListener;
-    std::map<std::string, My_SFML_MouseListener*>::iterator itMouseListener;
-    std::map<std::string, My_SFML_JoystickListener*>::iterator itJoystickListener;
-    std::map<std::string, My_SFML_WindowListener*>::iterator itWindowListener;
- 
-    std::map<std::string, My_SFML_KeyListener*>::iterator itKeyListenerEnd;
-    std::map<std::string, My_SFML_MouseListener*>::iterator itMouseListenerEnd;
-    std::map<std::string, My_SFML_JoystickListener*>::iterator itJoystickListenerEnd;
-    std::map<std::string, My_SFML_WindowListener*>::iterator itWindowListenerEnd;
+    std::vector< SFML_ListenerEntry<My_SFML_KeyListener> > mKeyListeners;
+    std::vector< SFML_ListenerEntry<My_SFML_MouseListener> > mMouseListeners;
+    std::vector< SFML_ListenerEntry<My_SFML_JoystickListener> > mJoystickListeners;
+    std::vector< SFML_ListenerEntry<My_SFML_WindowListener> > mWindowListeners;
+    std::vector< SFML_ListenerEntry<My_SFML_BatchListener> > mBatchListeners;
+
+    // This frame's events, kept for the batch listeners (reused, so no allocation once warm)
+    std::vector<sf::Event> mFrameEvents;
 };
 #endif
@@ -22,20 +22,29 @@ int main()
     gManager.setRenderWindow( &app );
     weManager.initialise( &app );
 
+    tManager.addTexture( "resources/UglyBlueMouse.png" );
+    tManager.addTexture( "resources/Button.png" );
+    tManager.addTexture( "resources/Button2.png" );
+    tManager.addTexture( "resources/Button3.png" );
+
+    TextureHandle button_look = tManager.internTexture( "resources/Button.png" );
+    TextureHandle button_hover = tManager.internTexture( "resources/Button2.png" );
+    TextureHandle button_pressed = tManager.internTexture( "resources/Button3.png" );
+
     cManager.createCursor( IMCursorManager::DEFAULT, tManager.getTexture( "resources/UglyBlueMouse.png" ));//, 30, 30 );
 
     IMButton* myButton = new IMInstantButton();
-    myButton->setNormalTexture( tManager.getTexture( "resources/Button.png" ) );
-    myButton->setHoverTexture( tManager.getTexture( "resources/Button2.png" ) );
-    myButton->setPressedTexture( tManager.getTexture( "resources/Button3.png" ) );
+    myButton->setNormalTexture( button_look );
+    myButton->setHoverTexture( button_hover );
+    myButton->setPressedTexture( button_pressed );
     myButton->setPosition( 10, 10 );
     myButton->setSize( 200, 200 );
     IMGuiManager::getSingleton().registerWidget( "Button", myButton );
 
     IMButton* myButton2 = new IMButton();
-    myButton2->setNormalTexture( tManager.getTexture( "resources/Button.png" ) );
-    myButton2->setHoverTexture( tManager.getTexture( "resources/Button2.png" ) );
-    myButton2->setPressedTexture( tManager.getTexture( "resources/Button3.png" ) );
+    myButton2->setNormalTexture( button_look );
+    myButton2->setHoverTexture( button_hover );
+    myButton2->setPressedTexture( button_pressed );
     myButton2->setPosition( 100, 100 );
     myButton2->setSize( 300, 300 );
     IMGuiManager::getSingleton().registerWidget( "Button2", myButton2 );
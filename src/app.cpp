@@ -6,6 +6,11 @@
 #include "listeners.h"
 #include "defs.h"
 #include "log.h"
+#include "pool.h"
+#include "replay.h"
+#include "autosave.h"
+#include "keymap.h"
+#include "loader.h"
 
 // SFML includes
 #include <SFML/Window.hpp>
@@ -22,9 +27,10 @@
 
 // C includes
 #include <stdio.h>
+#include <stdlib.h>
+#include <stdarg.h>
 
 // C++ includes
-#include <deque>
 #include <fstream>
 
 using namespace sf;
@@ -58,6 +64,12 @@ AppState app_state;
 
 // Specific data for the menu sections
 
+// Texture misses can turn up mid-frame, and log() doesn't wait on the disk
+void logTextureMiss( const std::string &message )
+{
+   log( message, LOG_LEVEL_WARNING );
+}
+
 void resetView()
 {
    r_window->setView( r_window->getDefaultView() );
@@ -76,22 +88,6 @@ void loadTestLevel()
 // Asset Loading
 ///////////////////////////////////////////////////////////////////////////////
 
-#define PROGESS_CAP 100
-
-#define ASSET_TYPE_END 0
-#define ASSET_TYPE_TEXTURE 1
-#define ASSET_TYPE_SOUND 2
-
-struct Asset
-{
-   int type;
-   string path;
-
-   Asset(int t, string& s) { type=t; path=s; }
-};
-
-deque<Asset> asset_list;
-
 int loadAssetList()
 {
    /* Actually read AssetList.txt 
@@ -100,28 +96,20 @@ int loadAssetList()
    ifstream alist_in;
    alist_in.open("res/AssetList.txt");
 
-   while (true) {
-      // Get next line
-      alist_in >> type >> path;
-      if (alist_in.eof())
-         break;
-
-      if (alist_in.bad()) {
-         log("Error in AssetList loading - alist_in is 'bad' - INVESTIGATE");
-         break;
-      }
+   if (!alist_in.is_open()) {
+      log("No res/AssetList.txt, nothing to load", LOG_LEVEL_WARNING);
+      return -1;
+   }
 
+   while (alist_in >> type >> path) {
       if (type == "IMAGE")
-         asset_list.push_back( Asset( ASSET_TYPE_TEXTURE, path ) );
+         queueAsset( ASSET_TEXTURE, path );
+      else
+         log("Unknown asset type in AssetList: " + type, LOG_LEVEL_WARNING);
    }
 
-   return 0;
-}
-
-int loadAsset( Asset& asset )
-{
-   if (asset.type == ASSET_TYPE_TEXTURE)
-      texture_manager->addTexture( asset.path );
+   if (alist_in.bad())
+      log("Error in AssetList loading - alist_in is 'bad' - INVESTIGATE", LOG_LEVEL_ERROR);
 
    return 0;
 }
@@ -148,31 +136,24 @@ int progressiveInit()
    return 1;
 }
 
-// progressiveLoad works through the assets a bit at a time
+// progressiveLoad is called once per frame of the loading screen until it returns 0
 int progressiveLoad()
 {
-   return 0;
-
-
-
    static int asset_segment = 0;
-   int progress = 0;
 
    switch (asset_segment) {
       case 0:
          // Need to load asset list first
          loadAssetList();
+         startAssetLoader();
          asset_segment = 1;
          return -1;
       case 1:
-         while (!asset_list.empty())
-         {
-            loadAsset( asset_list.front() );
-            asset_list.pop_front();
-            if (progress++ > PROGESS_CAP)
-               return -1;
+         // The workers decode, we upload what they've finished
+         if (finishLoadedAssets()) {
+            stopAssetLoader();
+            asset_segment = 2;
          }
-         asset_segment = 2;
          return -1;
       case 2:
          if (progressiveInit() == 0)
@@ -189,7 +170,6 @@ int progressiveLoad()
 int postload()
 {
    log("Postload");
-   //delete(asset_list);
 
    app_state = MAIN_MENU;
    return 0;
@@ -198,6 +178,19 @@ int postload()
 int loadingAnimation(int dt)
 {
    r_window->clear(sf::Color::Black);
+
+   // Progress bar
+   const float bar_x = 200, bar_y = 290, bar_width = 400, bar_height = 20;
+   sf::RectangleShape back( sf::Vector2f( bar_width, bar_height ) );
+   back.setFillColor( C_GRAY );
+   back.setPosition( bar_x, bar_y );
+   r_window->draw( back );
+
+   sf::RectangleShape done( sf::Vector2f( bar_width * assetLoadProgress(), bar_height ) );
+   done.setFillColor( C_WHITE );
+   done.setPosition( bar_x, bar_y );
+   r_window->draw( done );
+
    r_window->display();
    return 0;
 }
@@ -251,9 +244,24 @@ int writeChar( unsigned int c, sf::Color fg, sf::Color bg, int x, int y )
    return 0;
 }
 
-int writeString( std::string s, sf::Color fg, sf::Color bg, int x, int y )
+int writeString( const std::string &s, sf::Color fg, sf::Color bg, int x, int y )
+{
+   return writeString( s.data(), s.size(), fg, bg, x, y );
+}
+
+int writeString( const char *s, sf::Color fg, sf::Color bg, int x, int y )
+{
+   for( unsigned int i = 0; s[i] != '\0'; ++i ) {
+      if (x+i >= 80) break;
+
+      writeChar( s[i], fg, bg, x+i, y );
+   }
+   return 0;
+}
+
+int writeString( const char *s, int len, sf::Color fg, sf::Color bg, int x, int y )
 {
-   for( unsigned int i = 0; i < s.length(); ++i ) {
+   for( int i = 0; i < len; ++i ) {
       if (x+i >= 80) break;
 
       writeChar( s[i], fg, bg, x+i, y );
@@ -261,6 +269,18 @@ int writeString( std::string s, sf::Color fg, sf::Color bg, int x, int y )
    return 0;
 }
 
+int writeFormatted( sf::Color fg, sf::Color bg, int x, int y, const char *fmt, ... )
+{
+   char buf[81];
+
+   va_list args;
+   va_start( args, fmt );
+   vsnprintf( buf, sizeof(buf), fmt, args );
+   va_end( args );
+
+   return writeString( buf, fg, bg, x, y );
+}
+
 int colorInvert( int x_base, int y_base, int x_end, int y_end )
 {
    for( int y = y_base; y <= y_end; ++y ) {
@@ -377,13 +397,11 @@ bool MainMouseListener::mouseMoved( const sf::Event::MouseMoveEvent &mouse_move
 
 bool MainMouseListener::mouseButtonPressed( const sf::Event::MouseButtonEvent &mouse_button_press )
 {
-   log("Clicked");
    return true;
 }
 
 bool MainMouseListener::mouseButtonReleased( const sf::Event::MouseButtonEvent &mouse_button_release )
 {
-   log("Un-Clicked");
    return true;
 }
 
@@ -398,13 +416,14 @@ bool MainKeyListener::keyPressed( const sf::Event::KeyEvent &key_press )
    int mod = (key_press.alt?MOD_ALT:0) 
            | (key_press.shift?MOD_SHIFT:0) 
            | (key_press.control?MOD_CTRL:0);
+   bool repeat = trackKeyPress( key_press.code );
 
    if (app_state == MAIN_MENU) {
       if (sendKeyToMenu( key_press.code, mod ) == 1) // Game is ready to play
          app_state = IN_GAME;
    }
    else if (app_state == IN_GAME) {
-      sendKeyToGame( key_press.code, mod );
+      sendKeyToGame( key_press.code, mod, repeat );
    }
 
    return true;
@@ -412,6 +431,8 @@ bool MainKeyListener::keyPressed( const sf::Event::KeyEvent &key_press )
 
 bool MainKeyListener::keyReleased( const sf::Event::KeyEvent &key_release )
 {
+   trackKeyRelease( key_release.code );
+
    return true;
 }
 
@@ -435,13 +456,20 @@ int runApp()
    gui_manager->setRenderWindow( r_window );
 
    texture_manager->addSearchDirectory( "res/" ); 
+   texture_manager->setMissReporter( logTextureMiss );
+   // Everything the loader brings in gets packed, so sprites share textures
+   texture_manager->setAtlasMode( true );
 
    // Setup event listeners
    MainWindowListener w_listener;
    MainMouseListener m_listener;
    MainKeyListener k_listener;
    event_manager->addWindowListener( &w_listener, "main" );
-   event_manager->addMouseListener( &m_listener, "main" );
+   // Nothing here cares about the mouse moving, which is most mouse events
+   event_manager->addMouseListener( &m_listener, "main", 0,
+         SFML_EVENT_MASK( sf::Event::MouseButtonPressed ) |
+         SFML_EVENT_MASK( sf::Event::MouseButtonReleased ) |
+         SFML_EVENT_MASK( sf::Event::MouseWheelMoved ) );
    event_manager->addKeyListener( &k_listener, "main" );
 
    // We need to load a loading screen
@@ -456,7 +484,7 @@ int runApp()
    // Set Font
    if (!font.loadFromFile("res/LiberationMono-Regular.ttf"))
    {
-       log("Couldn't load font 'LiberationMono-Regular.tff'");
+       log("Couldn't load font 'LiberationMono-Regular.tff'", LOG_LEVEL_ERROR);
        exit(0);
    }
 
@@ -470,8 +498,8 @@ int runApp()
    postload();
 
    // Now setup some things using our new resources
-   //cursor_manager->createCursor( IMCursorManager::DEFAULT, texture_manager->getTexture( "FingerCursor.png" ), 0, 0, 40, 60);
-   //cursor_manager->createCursor( IMCursorManager::CLICKING, texture_manager->getTexture( "FingerCursorClick.png" ), 0, 0, 40, 60);
+   //cursor_manager->createCursor( IMCursorManager::DEFAULT, texture_manager->getRegion( "FingerCursor.png" ), 0, 0, 40, 60);
+   //cursor_manager->createCursor( IMCursorManager::CLICKING, texture_manager->getRegion( "FingerCursorClick.png" ), 0, 0, 40, 60);
 
    // Initialise some GUIs - first run-through is init
    progressiveInit();
@@ -479,6 +507,8 @@ int runApp()
 //////////////////////////////////////////////////////////////////////
 // Main Loop
 //////////////////////////////////////////////////////////////////////
+   startSaveWriter();
+
    log("Entering main loop");
    while (shutdown() == 0)
    {
@@ -498,6 +528,10 @@ int runApp()
    }
 
    log("End main loop");
+   stopRecording();
+   stopSaveWriter();
+   log( itemPool().describe() );
+   log( unitPool().describe() );
    
    r_window->close();
 
@@ -507,5 +541,30 @@ int runApp()
 
 int main(int argc, char* argv[])
 {
-   return runApp();
+   startLogger();
+   setLogTickSource( &ticks );
+
+   initKeymap();
+   if (loadKeymap() == 0)
+      log("Loaded key bindings from " DEFAULT_KEYMAP_FILE);
+
+   const char *replay_path = NULL;
+   for (int i = 1; i + 1 < argc; ++i) {
+      std::string arg = argv[i];
+      if (arg == "--record")
+         startRecording( argv[++i] );
+      else if (arg == "--replay")
+         replay_path = argv[++i];
+      else if (arg == "--input-depth")
+         setInputDepth( atoi( argv[++i] ) );
+   }
+
+   int result;
+   if (replay_path != NULL)
+      result = (openReplay( replay_path ) == 0) ? playReplay() : 1;
+   else
+      result = runApp();
+
+   stopLogger();
+   return result;
 }
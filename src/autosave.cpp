@@ -0,0 +1,130 @@
+#include "autosave.h"
+#include "log.h"
+
+#include <SFML/System.hpp>
+
+#include <cstdio>
+
+#ifdef _WIN32
+#include <io.h>
+#define fsync _commit
+#else
+#include <unistd.h>
+#endif
+
+int writeFileAtomically( const std::string &path, const std::vector<unsigned char> &data )
+{
+   std::string tmp_path = path + ".tmp";
+
+   FILE *f = fopen( tmp_path.c_str(), "wb" );
+   if (f == NULL) {
+      log("Couldn't open save file for writing: " + tmp_path, LOG_LEVEL_ERROR);
+      return -1;
+   }
+
+   // The data has to be on the disk before the rename makes it the save,
+   // or a crash could leave a complete-looking but empty file behind
+   size_t written = data.empty() ? 0 : fwrite( &data[0], 1, data.size(), f );
+   bool ok = (written == data.size()) && (fflush( f ) == 0) && (fsync( fileno( f ) ) == 0);
+   ok = (fclose( f ) == 0) && ok;
+
+   if (!ok) {
+      log("Couldn't write the whole save file: " + tmp_path, LOG_LEVEL_ERROR);
+      remove( tmp_path.c_str() );
+      return -2;
+   }
+
+   // rename() won't replace an existing file everywhere, so clear the way
+   if (rename( tmp_path.c_str(), path.c_str() ) != 0) {
+      remove( path.c_str() );
+      if (rename( tmp_path.c_str(), path.c_str() ) != 0) {
+         log("Couldn't move the new save into place: " + path, LOG_LEVEL_ERROR);
+         return -3;
+      }
+   }
+
+   return 0;
+}
+
+//////////////////////////////////////////////////////////////////////
+// Writer thread
+//////////////////////////////////////////////////////////////////////
+
+static sf::Mutex save_mutex;
+static std::vector<unsigned char> pending_data; // guarded by save_mutex
+static std::string pending_path;                 // guarded by save_mutex
+static bool pending = false;                     // guarded by save_mutex
+static bool stopping = false;                    // guarded by save_mutex
+
+static sf::Thread *writer_thread = NULL;
+
+static void saveWriterLoop()
+{
+   std::vector<unsigned char> data;
+   std::string path;
+
+   while (true) {
+      bool have_work = false, stop = false;
+      {
+         sf::Lock lock( save_mutex );
+         if (pending) {
+            data.swap( pending_data );
+            path = pending_path;
+            pending = false;
+            have_work = true;
+         }
+         stop = stopping;
+      }
+
+      if (have_work) {
+         writeFileAtomically( path, data );
+         data.clear();
+      }
+      else if (stop)
+         break;
+      else
+         sf::sleep( sf::milliseconds( 10 ) );
+   }
+}
+
+void startSaveWriter()
+{
+   if (writer_thread != NULL)
+      return;
+
+   stopping = false;
+   writer_thread = new sf::Thread( &saveWriterLoop );
+   writer_thread->launch();
+}
+
+void queueSave( const std::string &path, std::vector<unsigned char> &data )
+{
+   if (writer_thread == NULL) {
+      writeFileAtomically( path, data );
+      data.clear();
+      return;
+   }
+
+   sf::Lock lock( save_mutex );
+   if (pending)
+      log("Autosave writer fell behind, skipping an older save", LOG_LEVEL_WARNING);
+
+   pending_data.swap( data );
+   data.clear();
+   pending_path = path;
+   pending = true;
+}
+
+void stopSaveWriter()
+{
+   if (writer_thread == NULL)
+      return;
+
+   {
+      sf::Lock lock( save_mutex );
+      stopping = true;
+   }
+   writer_thread->wait();
+   delete writer_thread;
+   writer_thread = NULL;
+}
@@ -0,0 +1,27 @@
+#ifndef AUTOSAVE_H__
+#define AUTOSAVE_H__
+
+/* Writing save files without stalling the game.
+ *
+ * The game thread builds the save in memory (see writeGame in game.cpp)
+ * and hands the buffer to queueSave(), which just swaps it into a slot for
+ * the writer thread.  If the writer is still busy with an older save, the
+ * newer one replaces whatever was waiting, so turns never queue up behind
+ * the disk.
+ *
+ * Every file is written to <path>.tmp and then renamed over <path>, so a
+ * crash mid-write leaves the previous save intact.
+ */
+
+#include <vector>
+#include <string>
+
+int writeFileAtomically( const std::string &path, const std::vector<unsigned char> &data );
+
+void startSaveWriter();
+// Takes the contents of data, leaving it empty
+void queueSave( const std::string &path, std::vector<unsigned char> &data );
+// Finishes any waiting save, then stops the writer thread
+void stopSaveWriter();
+
+#endif
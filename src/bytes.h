@@ -0,0 +1,99 @@
+#ifndef BYTES_H__
+#define BYTES_H__
+
+/* Little-endian byte packing for save files.
+ *
+ * ByteWriter appends to a growing buffer that is written out in one go;
+ * ByteReader walks a buffer that was read in one go.  Reads past the end
+ * return zeroes and set 'bad', so a loader can parse a whole section and
+ * check once at the end instead of after every field.
+ */
+
+#include <stdint.h>
+#include <cstring>
+#include <vector>
+
+struct ByteWriter
+{
+   std::vector<unsigned char> data;
+
+   void put( uint64_t value, int bytes )
+   {
+      for (int i = 0; i < bytes; ++i)
+         data.push_back( (unsigned char) ((value >> (8 * i)) & 0xFF) );
+   }
+
+   void u8( unsigned int v ) { put( v, 1 ); }
+   void u16( unsigned int v ) { put( v, 2 ); }
+   void u32( uint32_t v ) { put( v, 4 ); }
+   void i32( int32_t v ) { put( (uint32_t) v, 4 ); }
+   void u64( uint64_t v ) { put( v, 8 ); }
+
+   void bytes( const void *src, size_t n )
+   {
+      const unsigned char *p = (const unsigned char*) src;
+      data.insert( data.end(), p, p + n );
+   }
+
+   // Reserves n bytes and returns where to fill them in, for bulk arrays
+   unsigned char* block( size_t n )
+   {
+      size_t at = data.size();
+      data.resize( at + n );
+      return n > 0 ? &data[at] : NULL;
+   }
+};
+
+struct ByteReader
+{
+   const unsigned char *data;
+   size_t size, pos;
+   bool bad;
+
+   ByteReader( const unsigned char *d, size_t s ) { data = d; size = s; pos = 0; bad = false; }
+
+   uint64_t get( int bytes )
+   {
+      if (pos + bytes > size) {
+         bad = true;
+         pos = size;
+         return 0;
+      }
+      uint64_t value = 0;
+      for (int i = 0; i < bytes; ++i)
+         value |= ((uint64_t) data[pos++]) << (8 * i);
+      return value;
+   }
+
+   unsigned int u8() { return (unsigned int) get( 1 ); }
+   unsigned int u16() { return (unsigned int) get( 2 ); }
+   uint32_t u32() { return (uint32_t) get( 4 ); }
+   int32_t i32() { return (int32_t) (uint32_t) get( 4 ); }
+   uint64_t u64() { return get( 8 ); }
+
+   size_t remaining() const { return size - pos; }
+
+   bool bytes( void *dest, size_t n )
+   {
+      const unsigned char *src = block( n );
+      if (src == NULL)
+         return false;
+      memcpy( dest, src, n );
+      return true;
+   }
+
+   // Points at the next n bytes and skips over them, NULL if there aren't n
+   const unsigned char* block( size_t n )
+   {
+      if (pos + n > size) {
+         bad = true;
+         pos = size;
+         return NULL;
+      }
+      const unsigned char *p = data + pos;
+      pos += n;
+      return p;
+   }
+};
+
+#endif
@@ -0,0 +1,84 @@
+#include "combat.h"
+#include "items.h"
+#include "syslog.h"
+
+static CombatEvent events[combat_event_memory];
+static unsigned int last_event = 0;
+
+unsigned int recordCombatEvent( const CombatEvent &event )
+{
+   last_event++;
+   events[last_event % combat_event_memory] = event;
+
+   writeSystemLogEvent( last_event, combatEventLines( event ) );
+   return last_event;
+}
+
+const CombatEvent* getCombatEvent( unsigned int number )
+{
+   if (number == 0 || number > last_event || last_event - number >= (unsigned int) combat_event_memory)
+      return NULL;
+
+   return &events[number % combat_event_memory];
+}
+
+unsigned int lastCombatEvent()
+{
+   return last_event;
+}
+
+void clearCombatEvents()
+{
+   last_event = 0;
+}
+
+int combatEventLines( const CombatEvent &event )
+{
+   // Weapon, outcome, and the item hit if there was one
+   if (event.target_item == NULL)
+      return 2;
+   return 3;
+}
+
+static const char* outcomeText( int flags )
+{
+   if (flags & COMBAT_REARMING)
+      return (flags & COMBAT_RANGED) ? " cannot fire yet." : " is disabled.";
+
+   if (flags & COMBAT_MISSED)
+      return (flags & COMBAT_RANGED) ? " misses." : " fails to connect.";
+
+   if (flags & COMBAT_RANGED) {
+      if (flags & COMBAT_DESTROYED) return " shoots and destroys";
+      if (flags & COMBAT_DISABLED) return " shoots and disables";
+      return " shoots and damages";
+   }
+
+   if (flags & COMBAT_PIERCING) {
+      if (flags & COMBAT_DESTROYED) return " pierces and destroys";
+      if (flags & COMBAT_DISABLED) return " pierces and disables";
+      return " pierces and damages";
+   }
+
+   if (flags & COMBAT_DESTROYED) return " hits and destroys";
+   if (flags & COMBAT_DISABLED) return " hits and disables";
+   return " hits and damages";
+}
+
+const char* combatEventText( const CombatEvent &event, int line, int &indent, char &pad )
+{
+   indent = 0;
+   pad = ' ';
+
+   if (line == 0) {
+      indent = 1;
+      pad = (event.flags & COMBAT_RANGED) ? '>' : '-';
+      return event.weapon->name;
+   }
+
+   if (line == 1)
+      return outcomeText( event.flags );
+
+   indent = 1;
+   return event.target_item->name;
+}
@@ -0,0 +1,55 @@
+#ifndef COMBAT_H__
+#define COMBAT_H__
+
+/* The combat event stream.
+ *
+ * Every swing and shot is recorded as a small CombatEvent rather than as
+ * text.  Events go into a ring of the last combat_event_memory events and
+ * are numbered from 1 in the order they happen; an old event number stays
+ * valid until the ring wraps past it.  The system log keeps only event
+ * numbers, and asks for the text when a line is first drawn, so fights
+ * nobody looks at never get formatted at all.
+ */
+
+#include "handle.h"
+
+struct ItemDef;
+struct Unit;
+
+// CombatEvent flags
+#define COMBAT_MELEE 0x1
+#define COMBAT_RANGED 0x2
+#define COMBAT_REARMING 0x4 // weapon wasn't ready, nothing happened
+#define COMBAT_MISSED 0x8
+#define COMBAT_PIERCING 0x10
+#define COMBAT_DISABLED 0x20
+#define COMBAT_DESTROYED 0x40 // the target item was destroyed
+#define COMBAT_KILLED 0x80 // ...and it was the chassis
+
+struct CombatEvent
+{
+   unsigned long int tick;
+   Handle attacker, target;
+   const ItemDef *weapon;
+   const ItemDef *target_item; // NULL if the attack didn't land
+   int damage;
+   int flags;
+};
+
+const int combat_event_memory = 128;
+
+// Records the event, adds it to the system log, and returns its number
+unsigned int recordCombatEvent( const CombatEvent &event );
+
+// NULL if 'number' hasn't happened yet or has been overwritten
+const CombatEvent* getCombatEvent( unsigned int number );
+unsigned int lastCombatEvent(); // 0 if there are none
+
+void clearCombatEvents();
+
+// System log text for an event.  Each event takes combatEventLines() lines;
+// combatEventText() gives one of them, with the indent to draw it at.
+int combatEventLines( const CombatEvent &event );
+const char* combatEventText( const CombatEvent &event, int line, int &indent, char &pad );
+
+#endif
@@ -0,0 +1,49 @@
+#include "components.h"
+
+UnitComponents::UnitComponents()
+{
+   position.reserve( initial_unit_capacity );
+   body.reserve( initial_unit_capacity );
+   look.reserve( initial_unit_capacity );
+   brain.reserve( initial_unit_capacity );
+}
+
+void UnitComponents::attach( Handle h )
+{
+   unsigned int n = h.index;
+   if (n >= position.size()) {
+      position.resize( n + 1 );
+      body.resize( n + 1 );
+      look.resize( n + 1 );
+      brain.resize( n + 1 );
+   }
+
+   position[n].level = NULL;
+   position[n].x = 0;
+   position[n].y = 0;
+
+   body[n].alive = true;
+   body[n].move_speed = 1000;
+   body[n].vision_range = 5;
+
+   look[n].display_char = '_';
+
+   brain[n].behavior = IDLE;
+   brain[n].onmyteam = false;
+   brain[n].aggro = 0;
+}
+
+void UnitComponents::detach( Handle h )
+{
+   if (h.index >= position.size())
+      return;
+
+   position[h.index].level = NULL;
+   body[h.index].alive = false;
+}
+
+UnitComponents& unitComponents()
+{
+   static UnitComponents components;
+   return components;
+}
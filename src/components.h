@@ -0,0 +1,84 @@
+#ifndef COMPONENTS_H__
+#define COMPONENTS_H__
+
+/* Unit components.
+ *
+ * The state every unit has - where it is, how fast it is, what it looks
+ * like, and for AIs what it's thinking - lives outside the Unit object in
+ * one dense array per component.  Slot n of every array belongs to the unit
+ * whose handle has index n (see handle.h), so the arrays stay as compact
+ * as the handle table and are reused as units come and go.
+ *
+ * Code that only needs one component, e.g. drawing every unit on the
+ * level, sweeps that array in order instead of chasing Unit pointers
+ * around the pools.  The Unit accessors (pos(), body(), ...) are the way
+ * to reach a single unit's slots.
+ *
+ * The arrays start with room for initial_unit_capacity units and only move
+ * if more than that are ever alive at once, but don't hold a reference to a
+ * slot across creating a unit - keep the slot number instead.
+ */
+
+#include "handle.h"
+
+#include <vector>
+
+struct Level;
+
+enum AIBehavior {
+   IDLE,
+   WANDER,
+   PATROL,
+   ATTACK_ENEMIES,
+   RUN_FROM_ENEMIES,
+
+   NUM_AI_BEHAVIORS
+};
+
+struct Position
+{
+   Level *level; // NULL if not on any map
+   int x, y;
+};
+
+struct Body
+{
+   bool alive;
+   int move_speed;
+   int vision_range;
+};
+
+struct Look
+{
+   unsigned int display_char;
+};
+
+struct Brain
+{
+   AIBehavior behavior;
+   bool onmyteam;
+   int aggro;
+};
+
+const unsigned int initial_unit_capacity = 1024;
+
+struct UnitComponents
+{
+   std::vector<Position> position;
+   std::vector<Body> body;
+   std::vector<Look> look;
+   std::vector<Brain> brain;
+
+   UnitComponents();
+
+   // Sizes every array to cover h and resets its slots to the defaults
+   void attach( Handle h );
+   // Takes a deleted unit's slots off the map
+   void detach( Handle h );
+
+   unsigned int size() const { return position.size(); }
+};
+
+UnitComponents& unitComponents();
+
+#endif
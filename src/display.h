@@ -7,7 +7,12 @@
 void clearDisplay();
 
 int writeChar( unsigned int c, sf::Color fg, sf::Color bg, int x, int y );
-int writeString( std::string s, sf::Color fg, sf::Color bg, int x, int y );
+int writeString( const std::string &s, sf::Color fg, sf::Color bg, int x, int y );
+int writeString( const char *s, sf::Color fg, sf::Color bg, int x, int y );
+// Writes at most 'len' characters of s, which needn't be terminated
+int writeString( const char *s, int len, sf::Color fg, sf::Color bg, int x, int y );
+// printf-style, formatted on the stack and cut to the display width
+int writeFormatted( sf::Color fg, sf::Color bg, int x, int y, const char *fmt, ... );
 int colorInvert( int x_base, int y_base, int x_end, int y_end );
 int colorSwitch( int x_base, int y_base, int x_end, int y_end );
 int dim( int x_base, int y_base, int x_end, int y_end );
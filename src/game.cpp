@@ -5,15 +5,26 @@
 #include "items.h"
 #include "units.h"
 #include "log.h"
+#include "syslog.h"
+#include "pool.h"
+#include "random.h"
+#include "combat.h"
+#include "replay.h"
+#include "bytes.h"
+#include "autosave.h"
+#include "input.h"
+#include "keymap.h"
 #include "defs.h"
 #include "SFML_GlobalRenderWindow.hpp"
 
 #include <vector>
 #include <queue>
-#include <stack>
-#include <deque>
 #include <sstream>
 #include <cmath>
+#include <cstdlib>
+#include <algorithm>
+#include <cstdio>
+#include <ctime>
 
 using namespace sf;
 
@@ -25,27 +36,15 @@ std::vector<Level*> all_levels;
 Level* current_level = NULL;
 
 Player* player;
-Unit* current_unit;
+Handle current_unit;
 
 Vector2u map_view_base; // The 0,0 of the view
 
 bool waiting_for_input;
+InputQueue input_queue; // Keys pressed while we weren't waiting for input
+unsigned long turns_taken = 0; // Unit turns handed out, for benchmarking
 
-enum GameState
-{
-   ON_MAP,
-   SELECTING_ABILITY,
-   TARGETTING,
-   TEXT_PAUSE,
-   INVENTORY_SCREEN,
-   INVENTORY_SELECT,
-   EQUIP_SCREEN,
-   EQUIP_INVENTORY,
-   PICK_UP,
-   HELP_SCREEN
-};
-
-GameState game_state;
+GameState game_state; // see keymap.h
 
 int selection, max_selection, menu_scroll, alt_selection, max_alt_selection; // Used in menus
 
@@ -57,47 +56,95 @@ unsigned long int ticks; // 'ticks' since game started
 
 const int system_log_width = 23;
 const int system_log_memory = 100;
-std::deque<std::string> system_log;
+
+struct SystemLogLine
+{
+   unsigned int event; // Combat event still to be formatted, or 0
+   int event_line;
+   char text[system_log_width + 1];
+};
+
+/* A ring of the last system_log_memory lines.  New lines overwrite the
+ * oldest in place, and line n back from the newest is found directly.
+ */
+SystemLogLine system_log[system_log_memory];
+int system_log_head = 0; // where the next line goes
+int system_log_count = 0;
 int system_log_scroll = 0;
 
-void writeSystemLog( std::string text )
+static void formatSystemLogLine( SystemLogLine &line, const char *text, int indent, char pad )
+{
+   int len = 0;
+   while (len < indent && len < system_log_width)
+      line.text[len++] = pad;
+   for (int i = 0; text[i] != '\0' && len < system_log_width; ++i)
+      line.text[len++] = text[i];
+   line.text[len] = '\0';
+}
+
+static SystemLogLine& nextSystemLogLine()
 {
-   if (text.size() > system_log_width)
-      text.resize( system_log_width );
-   system_log.push_front( text );
+   SystemLogLine &line = system_log[system_log_head];
+
+   system_log_head = (system_log_head + 1) % system_log_memory;
+   if (system_log_count < system_log_memory)
+      system_log_count++;
    system_log_scroll = 0;
 
-   if (system_log.size() > system_log_memory)
-      system_log.pop_back();
+   return line;
 }
 
-void clearSystemLog()
+void writeSystemLog( const char *text, int indent, char pad )
 {
-   system_log.clear();
+   SystemLogLine &line = nextSystemLogLine();
+   line.event = 0;
+   formatSystemLogLine( line, text, indent, pad );
 }
 
-//////////////////////////////////////////////////////////////////////
-// Time
-//////////////////////////////////////////////////////////////////////
-
-struct UnitTime
+void writeSystemLogEvent( unsigned int event, int lines )
 {
-   unsigned long tick; 
-   Unit* unit;
-
-   UnitTime( unsigned long t, Unit* u ) { tick = t; unit = u;}
-};
+   for (int i = 0; i < lines; ++i) {
+      SystemLogLine &line = nextSystemLogLine();
+      line.event = event;
+      line.event_line = i;
+   }
+}
 
-struct TimeQueueComparator
+// 0 is the newest line
+const char* systemLogLine( int n )
 {
-   bool operator() (const UnitTime &lhs, const UnitTime &rhs) {
-      return lhs.tick > rhs.tick;
+   if (n < 0 || n >= system_log_count)
+      return NULL;
+
+   SystemLogLine &line = system_log[(system_log_head - 1 - n + system_log_memory) % system_log_memory];
+   if (line.event != 0) {
+      // First time this line is shown
+      const CombatEvent *event = getCombatEvent( line.event );
+      if (event == NULL) {
+         line.text[0] = '\0';
+      }
+      else {
+         int indent;
+         char pad;
+         const char *text = combatEventText( *event, line.event_line, indent, pad );
+         formatSystemLogLine( line, text, indent, pad );
+      }
+      line.event = 0;
    }
-};
+   return line.text;
+}
 
-typedef std::priority_queue<UnitTime,std::vector<UnitTime>,TimeQueueComparator> TimeQueue;
+void clearSystemLog()
+{
+   clearCombatEvents();
+   system_log_head = 0;
+   system_log_count = 0;
+   system_log_scroll = 0;
+}
 
-TimeQueue time_queue;
+//////////////////////////////////////////////////////////////////////
+// Time
+//////////////////////////////////////////////////////////////////////
 
 // Using the TimeQueue
 
@@ -106,31 +153,158 @@ int addUnitToQueue( Unit* unit, unsigned long ticks_from_now )
    if (unit == NULL || ticks_from_now < 0)
       return -1;
 
-   time_queue.push( UnitTime( ticks_from_now + ticks, unit ) );
+   current_level->time_queue.push( UnitTime( ticks_from_now + ticks, unit->handle ) );
    return 0;
 }
 
+// Skips over any units deleted since they were queued
 Unit *getNextUnit()
 {
-   UnitTime ut = time_queue.top();
-   time_queue.pop();
-   ticks = ut.tick;
-   return (current_unit = ut.unit);
+   while (!current_level->time_queue.empty()) {
+      UnitTime ut = current_level->time_queue.top();
+      current_level->time_queue.pop();
+
+      Unit *unit = unitHandles().get( ut.unit );
+      if (unit == NULL)
+         continue;
+
+      ticks = ut.tick;
+      current_unit = ut.unit;
+      turns_taken++;
+      return unit;
+   }
+
+   current_unit = Handle();
+   return NULL;
+}
+
+/* Runs every AI turn due before the player's next one, without going back
+ * through playGame() and the virtual takeTurn() for each.  This is still a
+ * time queue walk, not a sweep of the component arrays: turns have to go in
+ * tick order, so each one is a handle lookup and a random-access read of
+ * that unit's slots (see aiTurn).  At most max_ai_batch turns go per call,
+ * in case the player isn't on this queue.
+ */
+const int max_ai_batch = 1000;
+
+void runAITurns()
+{
+   TimeQueue &queue = current_level->time_queue;
+   for (int batch = 0; batch < max_ai_batch && !queue.empty(); ++batch) {
+      UnitTime ut = queue.top();
+      if (player != NULL && ut.unit == player->handle)
+         break;
+      queue.pop();
+
+      Unit *unit = unitHandles().get( ut.unit );
+      if (unit == NULL)
+         continue;
+
+      ticks = ut.tick;
+      turns_taken++;
+
+      int speed = aiTurn( ut.unit.index, unit );
+      if (speed == -1) { // Unit is dead
+         delete unit;
+         continue;
+      }
+      queue.push( UnitTime( ticks + speed, ut.unit ) );
+   }
 }
 
 void clearCurrentUnit()
 {
-   current_unit = NULL;
+   current_unit = Handle();
    waiting_for_input = false;
 }
 
+// Suspended levels
+
+void suspendLevel( Level *level )
+{
+   level->suspended = true;
+   level->suspended_tick = ticks;
+}
+
+/* Brings a suspended level up to the current tick.  Instead of replaying
+ * every turn, each waiting unit gets one catchUp() call covering all the
+ * turns it missed, and is then rescheduled on the same beat as before.
+ * Must be called with level == current_level, since units move on it.
+ */
+void catchUpLevel( Level *level )
+{
+   if (!level->suspended)
+      return;
+
+   level->suspended = false;
+   if (ticks <= level->suspended_tick)
+      return;
+
+   std::vector<UnitTime> waiting;
+   while (!level->time_queue.empty()) {
+      waiting.push_back( level->time_queue.top() );
+      level->time_queue.pop();
+   }
+
+   for (unsigned int i = 0; i < waiting.size(); ++i) {
+      UnitTime &ut = waiting[i];
+
+      Unit *unit = unitHandles().get( ut.unit );
+      if (unit == NULL)
+         continue;
+
+      if (ut.tick < ticks) {
+         unsigned long missed = ticks - ut.tick;
+
+         if (unit->catchUp( missed ) == -1) { // Unit is dead
+            delete unit;
+            continue;
+         }
+
+         int speed = unit->body().move_speed;
+         unsigned long beat = speed > 0 ? speed : 1;
+         ut.tick += ((missed / beat) + 1) * beat;
+      }
+
+      level->time_queue.push( ut );
+   }
+}
+
+/* Deletes every unit and item belonging to 'level' in one sweep of the
+ * pools, and leaves the level empty.  Anything the player is carrying has
+ * already been moved to the persistent arena, so it survives.
+ */
+int freeLevelObjects( Level *level )
+{
+   std::vector<void*> doomed;
+
+   unitPool().collectArena( level->arena, doomed );
+   for (unsigned int i = 0; i < doomed.size(); ++i)
+      delete (Unit*) doomed[i];
+
+   doomed.clear();
+   itemPool().collectArena( level->arena, doomed );
+   for (unsigned int i = 0; i < doomed.size(); ++i)
+      delete (Item*) doomed[i];
+
+   for (unsigned int y = 0; y < level->y_dim; ++y) {
+      for (unsigned int x = 0; x < level->x_dim; ++x) {
+         level->map[y][x].unit = NULL;
+         level->map[y][x].items = NULL;
+      }
+   }
+   level->time_queue = TimeQueue();
+
+   return 0;
+}
+
 //////////////////////////////////////////////////////////////////////
 // Moving stuff around
 //////////////////////////////////////////////////////////////////////
 
 int putUnit( Unit* unit, int x, int y )
 {
-   Location &old_l = current_level->map[unit->pos_y][unit->pos_x];
+   Location &old_l = current_level->map[unit->pos().y][unit->pos().x];
    Location &new_l = current_level->map[y][x];
    if (new_l.unit != NULL) // Unit in the way
       return -2;
@@ -141,8 +315,10 @@ int putUnit( Unit* unit, int x, int y )
    // Go ahead and move
    old_l.unit = NULL;
    new_l.unit = unit;
-   unit->pos_x = x;
-   unit->pos_y = y;
+   Position &p = unit->pos();
+   p.level = current_level;
+   p.x = x;
+   p.y = y;
    return 0;
 }
 
@@ -184,7 +360,7 @@ int moveUnit( Unit* unit, Direction dir )
 {
    if (unit == NULL) return -1;
 
-   Vector2u dest( unit->pos_x, unit->pos_y );
+   Vector2u dest( unit->pos().x, unit->pos().y );
    addDirection( dir, dest );
    keepInBounds( dest );
 
@@ -193,24 +369,22 @@ int moveUnit( Unit* unit, Direction dir )
 
 int destroyUnit( Unit* target )
 {
-   std::stringstream txt;
-   txt << "!" << target->getName() << " destroyed!";
-   writeSystemLog( txt.str() );
-
-   Location &l = current_level->map[target->pos_y][target->pos_x];
+   char txt[64];
+   snprintf( txt, sizeof(txt), "!%s destroyed!", target->getName() );
+   writeSystemLog( txt );
 
-   Item *drops = target->inventory;
-   Item *it = drops;
-   if (it != NULL) {
-      while (it->next != NULL)
-         it = it->next;
+   Location &l = current_level->map[target->pos().y][target->pos().x];
 
+   while (!target->inventory.empty()) {
+      Item *it = target->inventory.removeAt( target->inventory.size() - 1 );
+      ObjectPool::setArena( it, current_level->arena );
       it->next = l.items;
-      l.items = drops;
+      l.items = it;
    }
 
    l.unit = NULL;
-   target->alive = false;
+   target->body().alive = false;
+   target->pos().level = NULL;
 
    return 0;
 }
@@ -303,11 +477,25 @@ void visionSource(uint x, uint y, uint radius) {
     }
 }
 
+// Part of the game logic, not the display: targetting reads MAP_VISIBLE
 void doFOV()
 {
+   Level *level = current_level;
+   const Position &p = player->pos();
+   int range = player->body().vision_range;
+
+   // Terrain only changes through linkLevels, so the same spot sees the same
+   if (p.x == level->fov_x && p.y == level->fov_y && range == level->fov_range)
+      return;
+
    blankVision();
-   visionSource( player->pos_x, player->pos_y, player->vision_range );
-   current_level->vision_map[player->pos_y][player->pos_x] |= MAP_VISIBLE | MAP_SEEN;
+   visionSource( p.x, p.y, range );
+   level->vision_map[p.y][p.x] |= MAP_VISIBLE | MAP_SEEN;
+
+   level->fov_x = p.x;
+   level->fov_y = p.y;
+   level->fov_range = range;
+   level->grids_dirty = true;
 }
 
 //////////////////////////////////////////////////////////////////////
@@ -320,57 +508,34 @@ const int invPageSize = 25;
 
 int getInventorySize()
 {
-   int size = 0;
-   Item *i = player->inventory;
-   while (i != NULL) {
-      size++;
-      i = i->next;
-   }
-   return size;
+   return player->inventory.size();
 }
   
 int addToInventory( Item *to_add )
 {
    if (to_add == NULL) return -1;
 
-   // Simple implementation
-   to_add->next = player->inventory;
-   player->inventory = to_add;
-   return 0;
+   // Carried items outlive the level they were found on
+   ObjectPool::setArena( to_add, PERSISTENT_ARENA );
+
+   // May stack to_add onto a matching item and delete it
+   return player->inventory.add( to_add );
 }
 
 int removeFromInventory( Item *i )
 {
-   Item *prev = player->inventory;
-
-   if (prev == NULL) return -1;
-
-   if (prev == i) {
-      player->inventory = prev->next;
-      i->next = NULL;
-      return 0;
-   }
-
-   while (prev != NULL) {
-      if (prev->next == i) {
-         prev->next = i->next; // removed
-         i->next = NULL;
-         return 0;
-      }
-      prev = prev->next;
-   }
-
-   return -2;
+   return player->inventory.remove( i );
 }
 
 int dropItem( Item *i )
 {
-   Location &drop_point = current_level->map[player->pos_y][player->pos_x];
+   Location &drop_point = current_level->map[player->pos().y][player->pos().x];
+   ObjectPool::setArena( i, current_level->arena );
    i->next = drop_point.items;
    drop_point.items = i;
 
    writeSystemLog( ">Dropped:" );
-   writeSystemLog( i->getNamePadded() );
+   writeSystemLog( i->getName(), 1 );
    return 0;
 }
 
@@ -381,7 +546,7 @@ int dropFromInventory( Item *i )
       return 0;
    }
 
-   log("Couldn't drop item, it was not in the inventory.");
+   log("Couldn't drop item, it was not in the inventory.", LOG_LEVEL_ERROR);
    return -2;
 }
 
@@ -435,9 +600,33 @@ int selectionPageUp()
    return 0;
 }
 
-int drawItemStack( Item *first, std::string header, bool alt=false, bool describe=true )
+void drawItemRow( Item *i, int count, int row, char alpha, bool describe )
+{
+   const int column = 4, column_end = 23;
+
+   writeChar( alpha, C_GRAY, C_BLACK, 2, row );
+   writeChar( ')', C_GRAY, C_BLACK, 3, row );
+
+   if (i->count > 1)
+      writeFormatted( C_WHITE, C_BLACK, column, row, "%s (%d)", i->getName(), i->count );
+   else
+      writeString( i->getName(), C_WHITE, C_BLACK, column, row );
+
+   if (count == selection) {
+      colorInvert( column, row, column_end, row );
+      if (describe) {
+         i->drawDescription();
+         if (game_state == INVENTORY_SELECT) {
+            i->drawActions();
+            colorInvert( actions_column, 13+alt_selection, actions_column+19, 13+alt_selection );
+         }
+      }
+   }
+}
+
+int drawItemStack( Item *first, const char *header, bool describe=true )
 {
-   const int column = 4, header_column = 2, column_end = 23;
+   const int header_column = 2;
    int row = 1;
    writeString( header, C_WHITE, C_BLACK, header_column, row );
    row++;
@@ -447,218 +636,95 @@ int drawItemStack( Item *first, std::string header, bool alt=false, bool describ
    int count = 0; 
    while (count < menu_scroll && i != NULL) {
       count++;
-      if (alt)
-         i = i->alt_next;
-      else
-         i = i->next;
+      i = i->next;
    }
 
    char alpha = 'a';
    while (i != NULL && row < 28) {
-      writeChar( alpha, C_GRAY, C_BLACK, 2, row );
-      writeChar( ')', C_GRAY, C_BLACK, 3, row );
+      drawItemRow( i, count, row, alpha, describe );
       alpha++;
 
-      writeString( i->getName(), C_WHITE, C_BLACK, column, row );
-      if (count == selection) {
-         colorInvert( column, row, column_end, row );
-         if (describe) {
-            i->drawDescription();
-            if (game_state == INVENTORY_SELECT) {
-               i->drawActions();
-               colorInvert( actions_column, 13+alt_selection, actions_column+19, 13+alt_selection );
-            }
-         }
-      }
-
       row++;
       count++;
-      if (alt)
-         i = i->alt_next;
-      else
-         i = i->next;
+      i = i->next;
+   }
+   return 0;
+}
+
+int drawItemSpan( ItemSpan items, const char *header, bool describe=true )
+{
+   const int header_column = 2;
+   int row = 1;
+   writeString( header, C_WHITE, C_BLACK, header_column, row );
+   row++;
+
+   // Only the visible rows are touched, however long the list
+   char alpha = 'a';
+   for (int count = menu_scroll; count < items.count && row < 28; ++count) {
+      drawItemRow( items[count], count, row, alpha, describe );
+      alpha++;
+      row++;
    }
    return 0;
 }
 
 int drawInventory()
 {
-   return drawItemStack( player->inventory, "Inventory:" );
+   return drawItemSpan( player->inventory.all(), "Inventory:" );
 }
 
 Item *invSelectedItem()
 {
-   Item *i = player->inventory;
-   int count = 0;
-   while (i != NULL) {
-      if (count == selection)
-         return i;
-
-      count++;
-      i = i->next;
-   }
-   return NULL;
+   return player->inventory.at( selection );
 }
 
-Item *inv_selected_prev = NULL;
-
 Item *invRemoveSelected()
 {
-   Item *i = player->inventory;
-   int count = 0;
-   if (selection == 0 && i != NULL) {
-      player->inventory = i->next;
-      i->next = NULL;
-      return i;
-   }
-   
-   inv_selected_prev = i;
-   count++;
-   i = i->next;
-
-   while (i != NULL) {
-      if (count == selection) {
-         inv_selected_prev->next = i->next;
-         i->next = NULL;
-         return i;
-      }
-
-      inv_selected_prev = i;
-      count++;
-      i = i->next;
-   }
-   return NULL; 
+   return player->inventory.takeAt( selection );
 }
 
 void invReplaceSelected( Item *i )
 {
-   if (selection == 0) {
-      i->next = player->inventory;
-      player->inventory = i;
-      return;
-   }
-   if (inv_selected_prev == NULL) {
-      Item *i = player->inventory;
-      int count = 0;
-      while (i != NULL) {
-         if (count == selection - 1) {
-            inv_selected_prev = i;
-            break;
-         }
-
-         count++;
-         i = i->next;
-      }
-   }
-
-   i->next = inv_selected_prev->next;
-   inv_selected_prev->next = i;
-
-   inv_selected_prev = NULL;
+   player->inventory.insert( selection, i );
 }
 
 // Limited Inventory = sorted/filtered
 
-Item *limited_inventory = NULL;
+std::vector<Item*> limited_inventory;
 
 void buildLimitedInventory( ItemType type ) {
-   Item *latest = player->inventory, *l_i_end = NULL;
-   bool match = false;
-   int count = 0;
-
-   limited_inventory = NULL;
-
-   while (latest != NULL) {
-      match = false;
-      switch (type) {
-         case CHASSIS:
-            if (latest->type == CHASSIS) match = true;
-            break;
-         case ARM:
-            if (latest->type == ARM) match = true;
-         case MOUNT:
-            if (latest->type == MOUNT) match = true;
-            break;
-         case SYSTEM:
-            if (latest->type == SYSTEM) match = true;
-            break;
-         case MISSILE:
-            if (latest->type == MISSILE) match = true;
-            break;
-         case GRENADE:
-            if (latest->type == GRENADE) match = true;
-            break;
-         case MINE:
-            if (latest->type == MINE) match = true;
-            break;
-         case TURRET:
-            if (latest->type == TURRET) match = true;
-            break;
-         case DEVICE:
-            if (latest->type == DEVICE) match = true;
-            break;
-         case CODE:
-            if (latest->type == CODE) match = true;
-            break;
-         case REMAINS:
-            if (latest->type == REMAINS) match = true;
-            break;
-      }
-      if (match) {
-         if (limited_inventory == NULL)
-            limited_inventory = latest;
-         else
-            l_i_end->alt_next = latest;
-
-         l_i_end = latest;
-         count++;
-      }
-      latest = latest->next;
+   ItemSpan matches = player->inventory.ofType( type );
+   limited_inventory.clear();
+   matches.appendTo( limited_inventory );
+
+   // ARM slots also take MOUNT items, see Chassis::addArm
+   if (type == ARM) {
+      matches = player->inventory.ofType( MOUNT );
+      matches.appendTo( limited_inventory );
    }
 
-   if (l_i_end)
-      l_i_end->alt_next = NULL;
-
-   max_selection = count;
+   max_selection = limited_inventory.size();
    selection = 0;
 }
 
-Item *invGetAllUsable()
+void invGetAllUsable( std::vector<Item*> &out )
 {
-   Item *first = NULL, *last = NULL, *it = player->inventory;
-
-   while (it != NULL) {
-      if (it->weapon_type == USABLE_WEAPON) {
-         if (first != NULL)
-            first = it;
-         else {
-            last->alt_next = it;
-            last = it;
-         }
-         it->alt_next = NULL;
-      }
-      it = it->next;
-   }
-   return first;
+   ItemSpan usable = player->inventory.ofWeaponType( USABLE_WEAPON );
+   usable.appendTo( out );
 }
 
 Item *limitedInvSelectedItem()
 {
-   Item *i = limited_inventory;
-   int count = 0;
-   while (i != NULL) {
-      if (count == selection)
-         return i;
-
-      count++;
-      i = i->alt_next;
-   }
-   return NULL;
+   if (selection < 0 || selection >= (int) limited_inventory.size())
+      return NULL;
+   return limited_inventory[selection];
 }
 
 int drawLimitedInventory()
 {
-   return drawItemStack( limited_inventory, "Limited Inventory:", true, false );
+   if (limited_inventory.empty())
+      return drawItemSpan( ItemSpan(), "Limited Inventory:", false );
+   return drawItemSpan( ItemSpan( &limited_inventory[0], limited_inventory.size() ), "Limited Inventory:", false );
 }
 
 // Another set of Item manipulations, for a generic stack
@@ -724,13 +790,13 @@ void stackReplaceSelected( Item *i )
 
 void examineLocation()
 { 
-   Location &player_loc = current_level->map[player->pos_y][player->pos_x];
+   Location &player_loc = current_level->map[player->pos().y][player->pos().x];
 
    if (player_loc.items != NULL) {
       Item *i = player_loc.items;
       writeSystemLog( ">Items here:" );
       while( i != NULL ) {
-         writeSystemLog( i->getNamePadded() );
+         writeSystemLog( i->getName(), 1 );
          i = i->next;
       }
    }
@@ -743,14 +809,14 @@ int movePlayer( Direction dir )
    int result = moveUnit( player, dir );
    if (result == 0) {
       examineLocation();
-      return player->move_speed;
+      return player->body().move_speed;
    } 
    else if (result == -1) { // Can't move there
       return 0;
    }
    else if (result == -2) { // Unit in the way
       // Melee attack enemy unit
-      Vector2u t_loc ( player->pos_x, player->pos_y );
+      Vector2u t_loc ( player->pos().x, player->pos().y );
       addDirection( dir, t_loc );
       Unit *target = current_level->map[t_loc.y][t_loc.x].unit;
 
@@ -763,6 +829,110 @@ int movePlayer( Direction dir )
    return -1;
 }
 
+// Stairs
+
+int exitIndex( Terrain ter )
+{
+   if (ter >= STAIRS_UP_1 && ter <= STAIRS_UP_4)
+      return ter - STAIRS_UP_1;
+   if (ter >= STAIRS_DOWN_1 && ter <= STAIRS_DOWN_4)
+      return 4 + (ter - STAIRS_DOWN_1);
+   return -1;
+}
+
+// Going up one set of stairs arrives at the matching down stairs, and vice versa
+Terrain arrivalStairs( Terrain ter )
+{
+   if (ter >= STAIRS_UP_1 && ter <= STAIRS_UP_4)
+      return (Terrain) (STAIRS_DOWN_1 + (ter - STAIRS_UP_1));
+   return (Terrain) (STAIRS_UP_1 + (ter - STAIRS_DOWN_1));
+}
+
+bool findTerrain( Level *level, Terrain ter, Vector2u &pos )
+{
+   for (unsigned int y = 0; y < level->y_dim; ++y) {
+      for (unsigned int x = 0; x < level->x_dim; ++x) {
+         if (level->map[y][x].ter == ter) {
+            pos = Vector2u( x, y );
+            return true;
+         }
+      }
+   }
+   return false;
+}
+
+// Nearest passable, empty cell to 'from', searching outward ring by ring
+bool findFreeCell( Level *level, Vector2u from, Vector2u &pos )
+{
+   int max_radius = std::max( level->x_dim, level->y_dim );
+   for (int r = 0; r < max_radius; ++r) {
+      for (int dy = -r; dy <= r; ++dy) {
+         for (int dx = -r; dx <= r; ++dx) {
+            if (std::max( abs( dx ), abs( dy ) ) != r)
+               continue; // Inside the ring, already checked
+
+            int x = (int) from.x + dx, y = (int) from.y + dy;
+            if (x < 0 || y < 0 || x >= (int) level->x_dim || y >= (int) level->y_dim)
+               continue;
+
+            Location &loc = level->map[y][x];
+            if (loc.ter > IMPASSABLE_WALL && loc.unit == NULL) {
+               pos = Vector2u( x, y );
+               return true;
+            }
+         }
+      }
+   }
+   return false;
+}
+
+// Returns the time taken, or -1 if there is no usable exit here
+int takeExit( bool going_up )
+{
+   Location &here = current_level->map[player->pos().y][player->pos().x];
+   int exit = exitIndex( here.ter );
+   if (exit == -1 || (exit < 4) != going_up)
+      return -1;
+
+   if (current_level->exits == NULL || current_level->exits[exit] == NULL) {
+      writeSystemLog( ">These stairs lead nowhere" );
+      return -1;
+   }
+
+   Level *dest = current_level->exits[exit];
+   Vector2u arrival;
+   if (!findTerrain( dest, arrivalStairs( here.ter ), arrival )) {
+      log("Exit leads to a level without matching stairs", LOG_LEVEL_ERROR);
+      return -1;
+   }
+
+   Level *from = current_level;
+   here.unit = NULL;
+   suspendLevel( from );
+   current_level = dest;
+   catchUpLevel( dest );
+
+   // Something may have wandered onto the stairs while we were away
+   Vector2u pos;
+   if (!findFreeCell( dest, arrival, pos )) {
+      suspendLevel( dest );
+      current_level = from;
+      catchUpLevel( from );
+      here.unit = player;
+      writeSystemLog( ">The way is blocked" );
+      return -1;
+   }
+
+   dest->map[pos.y][pos.x].unit = player;
+   Position &p = player->pos();
+   p.level = dest;
+   p.x = pos.x;
+   p.y = pos.y;
+
+   examineLocation();
+   return player->body().move_speed;
+}
+
 // Targetting
 
 Vector2u reticle;
@@ -775,9 +945,7 @@ int analyzeTarget( bool print=true )
       return 0;
 
    if (print) {
-      std::stringstream ss;
-      ss << " ::" << target->getName();
-      writeSystemLog( ss.str() );
+      writeSystemLog( target->getName(), 3, ':' );
    }
    return 1;
 }
@@ -877,59 +1045,69 @@ int targetSelectPrevious()
  * - Usable item (U)
  */
 
-Item *usable_stack = NULL;
-int usable_count = 0;
+std::vector<Item*> usable_stack;
 WeaponType usable_type;
 
+ItemSpan usableSpan()
+{
+   if (usable_stack.empty())
+      return ItemSpan();
+   return ItemSpan( &usable_stack[0], usable_stack.size() );
+}
+
 void initTacticalStack()
 {
-   max_selection = 0;
+   max_selection = usable_stack.size();
    selection = 0;
 
-   Item *item = usable_stack;
-   if (usable_stack == NULL)
+   if (usable_stack.empty())
       writeSystemLog( "Usable Stack is empty" );
 
-   while( item != NULL) {
-      max_selection++;
-      item = item->alt_next;
-   }
-   std::stringstream ss;
-   ss << "Max selection: " << max_selection;
-   writeSystemLog( ss.str() );
+   char txt[32];
+   snprintf( txt, sizeof(txt), "Max selection: %d", max_selection );
+   writeSystemLog( txt );
 }
 
 int initTacticalSelection( WeaponType type )
 {
+   ItemSpan equipped;
+
    usable_type = type;
+   usable_stack.clear();
    if (type == RANGED_WEAPON) {
-      usable_stack = player->chassis->getAllRanged();
+      equipped = player->chassis->getAllRanged();
 
    } else if (type == TACTICAL_WEAPON) {
-      usable_stack = player->chassis->getAllTactical();
+      equipped = player->chassis->getAllTactical();
 
    } else if (type == USABLE_WEAPON) {
-      usable_stack = invGetAllUsable();
+      invGetAllUsable( usable_stack );
 
    }
+   equipped.appendTo( usable_stack );
 
-   if (usable_stack == NULL)
+   if (usable_stack.empty())
       return -1;
 
    initTacticalStack();
    return 0;
 }
 
+Item *usableSelectedItem()
+{
+   if (selection < 0 || selection >= (int) usable_stack.size())
+      return NULL;
+   return usable_stack[selection];
+}
+
 int use()
 {
-   Item *use_item = usable_stack;
-   for (int i = 0; i < selection && use_item; ++i)
-      use_item = use_item->alt_next;
+   Item *use_item = usableSelectedItem();
 
    if (use_item == NULL)
       return -1;
    
-   if (use_item->targetted == true)
+   if (use_item->def->targetted == true)
       return 1; // Go to targetting
 
    writeSystemLog( "TODO: Using item" );
@@ -939,19 +1117,17 @@ int use()
 
 int fire()
 {
-   Item *use_item = usable_stack;
-   for (int i = 0; i < selection && use_item; ++i)
-      use_item = use_item->alt_next;
+   Item *use_item = usableSelectedItem();
 
    if (use_item == NULL)
       return -1;
 
    Unit *target = current_level->map[reticle.y][reticle.x].unit;
-   if (use_item->weapon_type == RANGED_WEAPON) {
-      use_item->rangedAttack( target );
+   if (use_item->def->weapon_type == RANGED_WEAPON) {
+      use_item->rangedAttack( player, target );
       return 0;
    }
-   if (use_item->weapon_type == TACTICAL_WEAPON) {
+   if (use_item->def->weapon_type == TACTICAL_WEAPON) {
       //use_item->tactical( target );
       return 0;
    }
@@ -962,11 +1138,11 @@ int fire()
 int drawUsableInventory()
 {
    if (usable_type == RANGED_WEAPON)
-      return drawItemStack( usable_stack, "Ranged Weaponry:", true );
+      return drawItemSpan( usableSpan(), "Ranged Weaponry:" );
    if (usable_type == TACTICAL_WEAPON)
-      return drawItemStack( usable_stack, "Tactical Weaponry:", true );
+      return drawItemSpan( usableSpan(), "Tactical Weaponry:" );
    if (usable_type == USABLE_WEAPON)
-      return drawItemStack( usable_stack, "Usable Items:", true );
+      return drawItemSpan( usableSpan(), "Usable Items:" );
 
    return -1;
 }
@@ -999,16 +1175,582 @@ Level *generateRandomLevel( LevelStyle style, int difficulty, int x_dim, int y_d
 // Game Creation/Loading
 //////////////////////////////////////////////////////////////////////
 
+const unsigned long autosave_interval = 20000; // ticks
+unsigned long next_autosave_tick = 0;
+
+// Throws away the whole game in progress
+void clearGame()
+{
+   std::vector<void*> doomed;
+
+   for (unsigned int i = 0; i < all_levels.size(); ++i)
+      freeLevelObjects( all_levels[i] );
+
+   // Then the player and everything they carry
+   unitPool().collectArena( PERSISTENT_ARENA, doomed );
+   for (unsigned int i = 0; i < doomed.size(); ++i)
+      delete (Unit*) doomed[i];
+
+   doomed.clear();
+   itemPool().collectArena( PERSISTENT_ARENA, doomed );
+   for (unsigned int i = 0; i < doomed.size(); ++i)
+      delete (Item*) doomed[i];
+
+   for (unsigned int i = 0; i < all_levels.size(); ++i)
+      delete all_levels[i];
+   all_levels.clear();
+
+   current_level = NULL;
+   player = NULL;
+   current_unit = Handle();
+   ticks = 0;
+   next_autosave_tick = 0;
+   waiting_for_input = false;
+   input_queue.clear();
+
+   usable_stack.clear();
+   limited_inventory.clear();
+   item_stack = stack_selected_prev = NULL;
+}
+
 void newGame()
 {
+   // There's no dungeon generator yet, so every game starts on the test level
+   clearGame();
+   testLevel();
+}
+
+// Saving and Loading
+
+/* Save file layout, all little-endian (see bytes.h):
+ *
+ *    "RJSV", u16 version
+ *    u64 ticks, u32 level count, u32 current level, i32 view x, i32 view y
+ *    per level:
+ *       u32 x_dim, u32 y_dim, u8 suspended, u64 suspended_tick
+ *       NUM_EXITS x i32 level the exit leads to, -1 for none
+ *       x_dim*y_dim x u8 terrain, row by row
+ *       x_dim*y_dim x u8 vision flags, row by row
+ *       u32 item count, then per item on the ground: u16 x, u16 y, item
+ *    u32 unit count, then per unit:
+ *       u8 is_player, u32 level, i32 x, i32 y
+ *       u8 alive, i32 move_speed, i32 vision_range, u32 display_char
+ *       u8 behavior, u8 onmyteam, i32 aggro
+ *       u8 has_chassis, then: item, u8 slot count, per slot u8 filled [item]
+ *       u32 inventory entries, then that many items
+ *       for the player: u16 name length, name
+ *    u32 current unit (its place in the unit list, NO_SAVE_ID for none)
+ *    per level: u32 queue length, then per entry: u64 tick, u32 unit
+ *
+ * An item is a fixed 13 bytes: u8 kind, i32 durability, i32 rearm_time,
+ * i32 count.  The terrain and vision grids are fixed-size arrays, and the
+ * whole file is read with a single fread, so loading is a pass over memory
+ * rather than a stream of small reads.
+ */
+
+static const char save_magic[4] = { 'R', 'J', 'S', 'V' };
+#define SAVE_VERSION 1
+#define NO_SAVE_ID 0xFFFFFFFF
+
+static int levelIndex( Level *level )
+{
+   for (unsigned int i = 0; i < all_levels.size(); ++i) {
+      if (all_levels[i] == level)
+         return i;
+   }
+   return -1;
+}
+
+static void writeItem( ByteWriter &w, Item *it )
+{
+   w.u8( it->def->kind );
+   w.i32( it->durability );
+   w.i32( it->rearm_time );
+   w.i32( it->count );
 }
 
-void loadGame()
+static Item* readItem( ByteReader &r )
 {
+   unsigned int kind = r.u8();
+   int durability = r.i32(), rearm_time = r.i32(), count = r.i32();
+   if (r.bad || kind >= NUM_ITEM_KINDS) {
+      r.bad = true;
+      return NULL;
+   }
+
+   Item *it = createItem( (ItemKind) kind );
+   it->durability = durability;
+   it->rearm_time = rearm_time;
+   it->count = count > 0 ? count : 1;
+   return it;
+}
+
+// Serialises the whole game into w
+void writeGame( ByteWriter &w )
+{
+   w.bytes( save_magic, sizeof(save_magic) );
+   w.u16( SAVE_VERSION );
+   w.u64( ticks );
+   w.u32( all_levels.size() );
+   w.u32( levelIndex( current_level ) );
+   w.i32( map_view_base.x );
+   w.i32( map_view_base.y );
+
+   std::vector<Unit*> units;
+
+   for (unsigned int n = 0; n < all_levels.size(); ++n) {
+      Level *level = all_levels[n];
+      unsigned int x_dim = level->x_dim, y_dim = level->y_dim;
+
+      w.u32( x_dim );
+      w.u32( y_dim );
+      w.u8( level->suspended );
+      w.u64( level->suspended_tick );
+      for (int e = 0; e < NUM_EXITS; ++e)
+         w.i32( level->exits == NULL ? -1 : levelIndex( level->exits[e] ) );
+
+      // Levels nobody has touched since the last save reuse their grids
+      if (level->grids_dirty || level->grid_cache.empty()) {
+         level->grid_cache.resize( 2 * x_dim * y_dim );
+         unsigned char *terrain = &level->grid_cache[0];
+         unsigned char *vision = terrain + x_dim * y_dim;
+         for (unsigned int y = 0; y < y_dim; ++y) {
+            for (unsigned int x = 0; x < x_dim; ++x) {
+               *terrain++ = (unsigned char) level->map[y][x].ter;
+               *vision++ = (unsigned char) level->vision_map[y][x];
+            }
+         }
+         level->grids_dirty = false;
+      }
+      w.bytes( &level->grid_cache[0], level->grid_cache.size() );
+
+      // Item count isn't known until the map's been walked, so patch it in
+      size_t count_at = w.data.size();
+      w.u32( 0 );
+      uint32_t item_count = 0;
+      for (unsigned int y = 0; y < y_dim; ++y) {
+         for (unsigned int x = 0; x < x_dim; ++x) {
+            Location &l = level->map[y][x];
+            for (Item *it = l.items; it != NULL; it = it->next) {
+               w.u16( x );
+               w.u16( y );
+               writeItem( w, it );
+               item_count++;
+            }
+            if (l.unit != NULL && l.unit->body().alive)
+               units.push_back( l.unit );
+         }
+      }
+      for (int b = 0; b < 4; ++b)
+         w.data[count_at + b] = (unsigned char) ((item_count >> (8 * b)) & 0xFF);
+   }
+
+   std::vector<uint32_t> save_ids( unitComponents().size(), NO_SAVE_ID );
+
+   w.u32( units.size() );
+   for (unsigned int i = 0; i < units.size(); ++i) {
+      Unit *u = units[i];
+      unsigned int c = u->handle.index;
+      save_ids[c] = i;
+
+      const Position &p = unitComponents().position[c];
+      const Body &b = unitComponents().body[c];
+      const Brain &br = unitComponents().brain[c];
+
+      w.u8( u == player );
+      w.u32( levelIndex( p.level ) );
+      w.i32( p.x );
+      w.i32( p.y );
+      w.u8( b.alive );
+      w.i32( b.move_speed );
+      w.i32( b.vision_range );
+      w.u32( unitComponents().look[c].display_char );
+      w.u8( br.behavior );
+      w.u8( br.onmyteam );
+      w.i32( br.aggro );
+
+      w.u8( u->chassis != NULL );
+      if (u->chassis != NULL) {
+         int slots = u->chassis->getTotalSlots();
+         writeItem( w, u->chassis );
+         w.u8( slots );
+         for (int s = 0; s < slots; ++s) {
+            Item *it = u->chassis->slots[s];
+            w.u8( it != NULL );
+            if (it != NULL)
+               writeItem( w, it );
+         }
+      }
+
+      ItemSpan inv = u->inventory.all();
+      w.u32( inv.count );
+      for (int n = 0; n < inv.count; ++n)
+         writeItem( w, inv[n] );
+
+      if (u == player) {
+         const std::string &name = player->personal_name;
+         w.u16( name.size() );
+         w.bytes( name.data(), name.size() );
+      }
+   }
+
+   Unit *cu = unitHandles().get( current_unit );
+   w.u32( cu == NULL ? NO_SAVE_ID : save_ids[cu->handle.index] );
+
+   for (unsigned int n = 0; n < all_levels.size(); ++n) {
+      TimeQueue queue = all_levels[n]->time_queue;
+      std::vector<UnitTime> live;
+      while (!queue.empty()) {
+         Unit *u = unitHandles().get( queue.top().unit );
+         if (u != NULL && save_ids[u->handle.index] != NO_SAVE_ID)
+            live.push_back( queue.top() );
+         queue.pop();
+      }
+
+      w.u32( live.size() );
+      for (unsigned int i = 0; i < live.size(); ++i) {
+         w.u64( live[i].tick );
+         w.u32( save_ids[unitHandles().get( live[i].unit )->handle.index] );
+      }
+   }
+}
+
+// Rebuilds the game from r; the current game must already be cleared
+// Anything bigger in a save file is taken as damage, not a real level
+const unsigned int max_level_dim = 1024;
+
+int readGame( ByteReader &r )
+{
+   char magic[4];
+   if (!r.bytes( magic, sizeof(magic) ) || memcmp( magic, save_magic, sizeof(magic) ) != 0) {
+      log("Not a save file", LOG_LEVEL_ERROR);
+      return -1;
+   }
+   if (r.u16() != SAVE_VERSION) {
+      log("Save file is from an unsupported version", LOG_LEVEL_ERROR);
+      return -2;
+   }
+
+   ticks = r.u64();
+   unsigned int num_levels = r.u32(), current = r.u32();
+   int view_x = r.i32(), view_y = r.i32();
+   map_view_base = Vector2u( view_x, view_y );
+
+   // Every level takes at least its two dimensions
+   if (r.bad || num_levels > r.remaining() / 8) {
+      log("Save file is damaged (level count)", LOG_LEVEL_ERROR);
+      return -3;
+   }
+
+   std::vector< std::vector<int> > exit_indexes( num_levels );
+   for (unsigned int n = 0; n < num_levels && !r.bad; ++n) {
+      unsigned int x_dim = r.u32(), y_dim = r.u32();
+      if (r.bad || x_dim == 0 || y_dim == 0 || x_dim > max_level_dim || y_dim > max_level_dim
+            || r.remaining() < 2 * x_dim * y_dim) { // Terrain and vision still to come
+         r.bad = true;
+         break;
+      }
+
+      Level *level = new Level( x_dim, y_dim );
+      all_levels.push_back( level );
+      level->suspended = r.u8();
+      level->suspended_tick = r.u64();
+      for (int e = 0; e < NUM_EXITS; ++e)
+         exit_indexes[n].push_back( r.i32() );
+
+      const unsigned char *terrain = r.block( x_dim * y_dim );
+      const unsigned char *vision = r.block( x_dim * y_dim );
+      if (terrain == NULL || vision == NULL)
+         break;
+
+      for (unsigned int y = 0; y < y_dim; ++y) {
+         for (unsigned int x = 0; x < x_dim; ++x) {
+            level->map[y][x].ter = (Terrain) *terrain++;
+            level->vision_map[y][x] = *vision++;
+         }
+      }
+
+      // Keep each pile in the order it was saved
+      std::vector<Item*> pile_end( x_dim * y_dim, (Item*) NULL );
+      allocation_arena = level->arena;
+      unsigned int item_count = r.u32();
+      for (unsigned int i = 0; i < item_count && !r.bad; ++i) {
+         unsigned int x = r.u16(), y = r.u16();
+         Item *it = readItem( r );
+         if (it == NULL || x >= x_dim || y >= y_dim) {
+            delete it;
+            r.bad = true;
+            break;
+         }
+
+         Item *&end = pile_end[y * x_dim + x];
+         if (end == NULL)
+            level->map[y][x].items = it;
+         else
+            end->next = it;
+         end = it;
+      }
+      allocation_arena = PERSISTENT_ARENA;
+   }
+   if (r.bad || current >= all_levels.size()) {
+      log("Save file is damaged (levels)", LOG_LEVEL_ERROR);
+      return -3;
+   }
+
+   for (unsigned int n = 0; n < all_levels.size(); ++n) {
+      bool has_exits = false;
+      for (int e = 0; e < NUM_EXITS; ++e)
+         has_exits |= (exit_indexes[n][e] >= 0 && exit_indexes[n][e] < (int) all_levels.size());
+      if (!has_exits)
+         continue;
+
+      all_levels[n]->exits = new Level*[NUM_EXITS];
+      for (int e = 0; e < NUM_EXITS; ++e) {
+         int x = exit_indexes[n][e];
+         all_levels[n]->exits[e] = (x >= 0 && x < (int) all_levels.size()) ? all_levels[x] : NULL;
+      }
+   }
+   current_level = all_levels[current];
+
+   unsigned int num_units = r.u32();
+   std::vector<Unit*> units;
+   for (unsigned int i = 0; i < num_units && !r.bad; ++i) {
+      bool is_player = r.u8();
+      unsigned int level_index = r.u32();
+      int x = r.i32(), y = r.i32();
+      if (r.bad || level_index >= all_levels.size()) {
+         r.bad = true;
+         break;
+      }
+      Level *level = all_levels[level_index];
+      if (x < 0 || y < 0 || x >= (int) level->x_dim || y >= (int) level->y_dim
+            || level->map[y][x].unit != NULL
+            || (is_player && player != NULL)) { // Only one player
+         r.bad = true;
+         break;
+      }
+
+      // The player and their gear travel between levels, the rest stay put
+      allocation_arena = is_player ? PERSISTENT_ARENA : level->arena;
+
+      Unit *u;
+      if (is_player)
+         u = player = new Player();
+      else
+         u = new AI();
+      units.push_back( u );
+
+      unsigned int c = u->handle.index;
+      Position &p = unitComponents().position[c];
+      p.level = level;
+      p.x = x;
+      p.y = y;
+      level->map[y][x].unit = u;
+
+      Body &b = unitComponents().body[c];
+      b.alive = r.u8();
+      b.move_speed = r.i32();
+      b.vision_range = r.i32();
+      unitComponents().look[c].display_char = r.u32();
+
+      Brain &br = unitComponents().brain[c];
+      unsigned int behavior = r.u8();
+      if (behavior >= NUM_AI_BEHAVIORS) {
+         r.bad = true;
+         break;
+      }
+      br.behavior = (AIBehavior) behavior;
+      br.onmyteam = r.u8();
+      br.aggro = r.i32();
+
+      delete u->chassis;
+      u->chassis = NULL;
+      if (r.u8()) {
+         Item *ch = readItem( r );
+         if (ch == NULL || ch->def->type != CHASSIS) {
+            delete ch;
+            r.bad = true;
+            break;
+         }
+         u->chassis = (Chassis*) ch;
+
+         int slots = r.u8();
+         for (int s = 0; s < slots && !r.bad; ++s) {
+            if (!r.u8())
+               continue;
+            Item *it = readItem( r );
+            if (it == NULL || u->chassis->restoreSlot( s, it ) != 0) {
+               delete it;
+               r.bad = true;
+            }
+         }
+      }
+
+      unsigned int inv_count = r.u32();
+      for (unsigned int n = 0; n < inv_count && !r.bad; ++n) {
+         Item *it = readItem( r );
+         if (it != NULL)
+            u->inventory.add( it );
+      }
+
+      if (is_player) {
+         unsigned int len = r.u16();
+         const unsigned char *name = r.block( len );
+         if (name != NULL)
+            player->personal_name.assign( (const char*) name, len );
+      }
+   }
+   allocation_arena = PERSISTENT_ARENA;
+
+   unsigned int cu = r.u32();
+   if (r.bad || player == NULL) {
+      log("Save file is damaged (units)", LOG_LEVEL_ERROR);
+      return -4;
+   }
+   current_unit = cu < units.size() ? units[cu]->handle : player->handle;
+
+   for (unsigned int n = 0; n < all_levels.size() && !r.bad; ++n) {
+      unsigned int queue_length = r.u32();
+      for (unsigned int i = 0; i < queue_length && !r.bad; ++i) {
+         unsigned long tick = r.u64();
+         unsigned int id = r.u32();
+         if (id < units.size())
+            all_levels[n]->time_queue.push( UnitTime( tick, units[id]->handle ) );
+      }
+   }
+   if (r.bad) {
+      log("Save file is damaged (time queues)", LOG_LEVEL_ERROR);
+      return -5;
+   }
+
+   return 0;
+}
+
+int saveGame( const char *path )
+{
+   if (current_level == NULL || player == NULL)
+      return -1;
+
+   // A replayed save goes through the motions but mustn't touch the real one
+   if (replaying())
+      return 0;
+
+   sf::Clock clock;
+
+   ByteWriter w;
+   writeGame( w );
+
+   if (writeFileAtomically( path, w.data ) != 0)
+      return -2;
+
+   std::stringstream ss;
+   ss << "Saved " << w.data.size() << " bytes in " << clock.getElapsedTime().asMilliseconds() << "ms";
+   log( ss.str() );
+   return 0;
+}
+
+// Autosaving
+
+/* Called at the start of the player's turn.  Only building the save in
+ * memory happens here; the disk write happens on the save writer thread.
+ */
+void autosave()
+{
+   if (replaying() || ticks < next_autosave_tick)
+      return;
+   next_autosave_tick = ticks + autosave_interval;
+
+   sf::Clock clock;
+
+   ByteWriter w;
+   writeGame( w );
+   size_t size = w.data.size();
+   queueSave( AUTOSAVE_FILE, w.data );
+
+   std::stringstream ss;
+   ss << "Autosave snapshot of " << size << " bytes took " << clock.getElapsedTime().asMicroseconds() << "us";
+   log( ss.str() );
+}
+
+int loadGame( const char *path )
+{
+   sf::Clock clock;
+
+   FILE *f = fopen( path, "rb" );
+   if (f == NULL) {
+      log(std::string("Couldn't open save file: ") + path, LOG_LEVEL_ERROR);
+      return -1;
+   }
+
+   fseek( f, 0, SEEK_END );
+   long size = ftell( f );
+   fseek( f, 0, SEEK_SET );
+
+   std::vector<unsigned char> data( size > 0 ? size : 0 );
+   size_t got = size > 0 ? fread( &data[0], 1, size, f ) : 0;
+   fclose( f );
+   if (size <= 0 || got != (size_t) size) {
+      log("Couldn't read the save file", LOG_LEVEL_ERROR);
+      return -2;
+   }
+
+   clearGame();
+
+   // A replay always starts from a new game, so it can't follow this one
+   if (recording()) {
+      log("Loaded a saved game; stopped recording the replay", LOG_LEVEL_WARNING);
+      stopRecording();
+   }
+
+   ByteReader r( &data[0], data.size() );
+   int result = readGame( r );
+   if (result != 0) {
+      clearGame();
+      return result;
+   }
+
+   next_autosave_tick = ticks + autosave_interval;
+   game_state = ON_MAP;
+   clearSystemLog();
+   writeSystemLog( ">Game loaded" );
+
+   std::stringstream ss;
+   ss << "Loaded " << data.size() << " bytes in " << clock.getElapsedTime().asMilliseconds() << "ms";
+   log( ss.str() );
+   return 0;
+}
+
+// Puts stairs on both levels, leading to each other
+void linkLevels( Level *upper, int upper_x, int upper_y, Level *lower, int lower_x, int lower_y )
+{
+   Level *levels[2] = { upper, lower };
+   for (int i = 0; i < 2; ++i) {
+      if (levels[i]->exits == NULL) {
+         levels[i]->exits = new Level*[NUM_EXITS];
+         for (int e = 0; e < NUM_EXITS; ++e)
+            levels[i]->exits[e] = NULL;
+      }
+   }
+
+   upper->map[upper_y][upper_x].ter = STAIRS_DOWN_1;
+   lower->map[lower_y][lower_x].ter = STAIRS_UP_1;
+   for (int i = 0; i < 2; ++i) {
+      levels[i]->grids_dirty = true;
+      levels[i]->fov_range = -1;
+   }
+   upper->exits[exitIndex( STAIRS_DOWN_1 )] = lower;
+   lower->exits[exitIndex( STAIRS_UP_1 )] = upper;
 }
 
 void testLevel()
 {
+   seedRandom( replaying() ? replaySeed() : (uint64_t) time( NULL ) );
+   recordSeed( getRandomSeed() );
+
+   std::stringstream ss;
+   ss << "Random seed: " << getRandomSeed();
+   log( ss.str() );
+
    Level* tl = new Level( 100, 100 );
    current_level = tl;
    all_levels.push_back(tl);
@@ -1024,29 +1766,41 @@ void testLevel()
    }
    tl->map[20][26].ter = FLOOR;
 
+   // A second level to go down to
+   Level *lower = new Level( 100, 100 );
+   all_levels.push_back( lower );
+   suspendLevel( lower );
+   linkLevels( tl, 23, 25, lower, 50, 50 );
+
    blankVision();
 
    player = new Player();
    putUnit( player, 25, 25 );
-   current_unit = player;
+   current_unit = player->handle;
 
-   player->chassis = new BasicChassis();
-   player->chassis->addArm( new ClawArm() );
-   player->chassis->addArm( new Laser() );
+   player->chassis = new Chassis( BASIC_CHASSIS );
+   player->chassis->addArm( createItem( CLAW_ARM ) );
+   player->chassis->addArm( createItem( LASER ) );
 
    for (int s = 0; s < 20; ++s)
-      addToInventory( new ClawArm() );
+      addToInventory( createItem( CLAW_ARM ) );
 
    for (int r = 0; r < 20; ++r)
-      addToInventory( new HammerArm() );
+      addToInventory( createItem( HAMMER_ARM ) );
 
-   addToInventory( new Laser() );
+   addToInventory( createItem( LASER ) );
+
+   // Everything from here on belongs to the level
+   allocation_arena = tl->arena;
 
    Unit* rr = new AI();
    putUnit( rr, 27, 28 );
    addUnitToQueue( rr, 500 );
-   rr->inventory = new EnergyLance();
+   rr->inventory.add( createItem( ENERGY_LANCE ) );
+
+   allocation_arena = PERSISTENT_ARENA;
 
+   next_autosave_tick = ticks + autosave_interval;
    game_state = ON_MAP;
    clearSystemLog();
 }
@@ -1055,234 +1809,162 @@ void testLevel()
 // Main Interface
 //////////////////////////////////////////////////////////////////////
 
-struct KeyInput {
-   Keyboard::Key k;
-   int mod;
-
-   KeyInput( Keyboard::Key kk ) {k = kk; mod = 0;}
-   KeyInput( Keyboard::Key kk, int m ) {k = kk; mod = m;}
-};
-
-std::stack<KeyInput> input_stack;
-
 bool alphaSelect( Keyboard::Key k, int scroll_offset, bool alt )
 {
-   int new_select = -1, max_select = max_selection;
+   if (k < Keyboard::A || k > Keyboard::Z)
+      return false;
+
+   int max_select = max_selection;
    if (alt)
       max_select = max_alt_selection;
 
    max_select += scroll_offset;
 
-   if (k == Keyboard::A && max_select >= 1) {
-      new_select = 0; } else
-   if (k == Keyboard::B && max_select >= 2) {
-      new_select = 1; } else
-   if (k == Keyboard::C && max_select >= 3) {
-      new_select = 2; } else
-   if (k == Keyboard::D && max_select >= 4) {
-      new_select = 3; } else
-   if (k == Keyboard::E && max_select >= 5) {
-      new_select = 4; } else
-   if (k == Keyboard::F && max_select >= 6) {
-      new_select = 5; } else
-   if (k == Keyboard::G && max_select >= 7) {
-      new_select = 6; } else
-   if (k == Keyboard::H && max_select >= 8) {
-      new_select = 7; } else
-   if (k == Keyboard::I && max_select >= 9) {
-      new_select = 8; } else
-   if (k == Keyboard::J && max_select >= 10) {
-      new_select = 9; } else
-   if (k == Keyboard::K && max_select >= 11) {
-      new_select = 10; } else
-   if (k == Keyboard::L && max_select >= 12) {
-      new_select = 11; } else
-   if (k == Keyboard::M && max_select >= 13) {
-      new_select = 12; } else
-   if (k == Keyboard::N && max_select >= 14) {
-      new_select = 13; } else
-   if (k == Keyboard::O && max_select >= 15) {
-      new_select = 14; } else
-   if (k == Keyboard::P && max_select >= 16) {
-      new_select = 15; } else
-   if (k == Keyboard::Q && max_select >= 17) {
-      new_select = 16; } else
-   if (k == Keyboard::R && max_select >= 18) {
-      new_select = 17; } else
-   if (k == Keyboard::S && max_select >= 19) {
-      new_select = 18; } else
-   if (k == Keyboard::T && max_select >= 20) {
-      new_select = 19; } else
-   if (k == Keyboard::U && max_select >= 21) {
-      new_select = 20; } else
-   if (k == Keyboard::V && max_select >= 22) {
-      new_select = 21; } else
-   if (k == Keyboard::W && max_select >= 23) {
-      new_select = 22; } else
-   if (k == Keyboard::X && max_select >= 24) {
-      new_select = 23; } else
-   if (k == Keyboard::Y && max_select >= 25) {
-      new_select = 24; } else
-   if (k == Keyboard::Z && max_select >= 26) {
-      new_select = 25; }
-
-   if (new_select != -1) {
-      new_select += scroll_offset;
-
-      if (alt)
-         alt_selection = new_select;
-      else
-         selection = new_select;
+   int new_select = k - Keyboard::A;
+   if (new_select >= max_select)
+      return false;
 
-      return true;
-   }
+   new_select += scroll_offset;
+
+   if (alt)
+      alt_selection = new_select;
    else
-      return false;
+      selection = new_select;
+
+   return true;
 }
 
-int sendKeyToGame( Keyboard::Key k, int mod )
-{
-   if (k == Keyboard::Q && (mod & MOD_SHIFT))
-      shutdown(1, 1);
+// Key handlers, one per GameState
 
-   if (!waiting_for_input) {
-      input_stack.push(KeyInput(k, mod));
-      return 1;
-   }
-
-   if (game_state == TEXT_PAUSE) {
-      if (k == Keyboard::Space || k == Keyboard::Return) {
-         // Continue
-      }
-      return 2;
-   }
-   
-   if (game_state == SELECTING_ABILITY) {
-      if (k == Keyboard::Escape || k == Keyboard::BackSpace) {
+int abilityKey( GameCommand cmd )
+{
+   switch (cmd) {
+      case CMD_CANCEL:
          game_state = ON_MAP;
-      } else
-      if (k == Keyboard::Numpad2 || k == Keyboard::Down) {
-         selectionDown(); } else
-      if (k == Keyboard::Numpad8 || k == Keyboard::Up) {
-         selectionUp(); } else
-      if (k == Keyboard::PageDown) {
-         selectionPageDown(); } else
-      if (k == Keyboard::PageUp) {
-         selectionPageUp(); } else
-      if (k == Keyboard::Space || k == Keyboard::Return) {
+         break;
+      case CMD_DOWN: selectionDown(); break;
+      case CMD_UP: selectionUp(); break;
+      case CMD_PAGE_DOWN: selectionPageDown(); break;
+      case CMD_PAGE_UP: selectionPageUp(); break;
+      case CMD_CONFIRM:
          if (use() == 1) {
             game_state = TARGETTING;
             targetSelectNext();
          } else {
             game_state = ON_MAP;
          }
-      }
+         break;
+      default:
+         break;
+   }
+   return 0;
+}
 
+int targettingKey( GameCommand cmd )
+{
+   if (cmd >= CMD_NORTH && cmd <= CMD_NORTHWEST) {
+      targetMoveSelector( (Direction) (cmd - CMD_NORTH) );
       return 0;
    }
 
-   if (game_state == TARGETTING) {
-      if (k == Keyboard::Escape || k == Keyboard::BackSpace) {
+   switch (cmd) {
+      case CMD_CANCEL:
          game_state = SELECTING_ABILITY;
-      } else
-      if (k == Keyboard::Numpad1){
-         targetMoveSelector( SOUTHWEST ); } else
-      if (k == Keyboard::Numpad2 || k == Keyboard::Down){
-         targetMoveSelector( SOUTH ); } else
-      if (k == Keyboard::Numpad3){
-         targetMoveSelector( SOUTHEAST ); } else
-      if (k == Keyboard::Numpad4 || k == Keyboard::Left){
-         targetMoveSelector( WEST ); } else
-      if (k == Keyboard::Numpad6 || k == Keyboard::Right){
-         targetMoveSelector( EAST ); } else
-      if (k == Keyboard::Numpad7){
-         targetMoveSelector( NORTHWEST ); } else
-      if (k == Keyboard::Numpad8 || k == Keyboard::Up){
-         targetMoveSelector( NORTH ); } else
-      if (k == Keyboard::Numpad9){
-         targetMoveSelector( NORTHEAST ); } else
-      if (k == Keyboard::N || k == Keyboard::PageDown) {
-         targetSelectNext(); } else
-      if (k == Keyboard::P || k == Keyboard::PageUp) {
-         targetSelectPrevious(); } else
-      if (k == Keyboard::Space || k == Keyboard::Return) {
+         break;
+      case CMD_NEXT_TARGET: targetSelectNext(); break;
+      case CMD_PREV_TARGET: targetSelectPrevious(); break;
+      case CMD_CONFIRM:
          if (analyzeTarget(false)) {
             fire();
             game_state = ON_MAP;
          } else {
             writeSystemLog( ">ERROR: No target selected" );
          }
-      }
+         break;
+      default:
+         break;
+   }
+   return 0;
+}
 
-      return 0;
+int textPauseKey( GameCommand cmd )
+{
+   if (cmd == CMD_CONFIRM) {
+      // Continue
    }
-   
-   if (game_state == PICK_UP) {
-      if (k == Keyboard::Escape || k == Keyboard::BackSpace) {
-         current_level->map[player->pos_y][player->pos_x].items = item_stack;
+   return 2;
+}
+
+int pickUpKey( GameCommand cmd )
+{
+   switch (cmd) {
+      case CMD_CANCEL:
+         current_level->map[player->pos().y][player->pos().x].items = item_stack;
          game_state = ON_MAP;
-      } else
-      if (k == Keyboard::Numpad2 || k == Keyboard::Down) {
-         selectionDown(); } else
-      if (k == Keyboard::Numpad8 || k == Keyboard::Up) {
-         selectionUp(); } else
-      if (k == Keyboard::PageDown) {
-         selectionPageDown(); } else
-      if (k == Keyboard::PageUp) {
-         selectionPageUp(); } else
-      if (k == Keyboard::Space || k == Keyboard::Return) {
+         break;
+      case CMD_DOWN: selectionDown(); break;
+      case CMD_UP: selectionUp(); break;
+      case CMD_PAGE_DOWN: selectionPageDown(); break;
+      case CMD_PAGE_UP: selectionPageUp(); break;
+      case CMD_CONFIRM: {
          Item *selected = stackRemoveSelected();
          if (selected != NULL) {
             selected->next = NULL;
-            addToInventory( selected );
             max_selection--;
             if (selection == max_selection) selection--;
-            writeSystemLog( selected->getNamePadded() );
+            writeSystemLog( selected->getName(), 1 );
+            addToInventory( selected );
          }
          if (item_stack == NULL) {
-            current_level->map[player->pos_y][player->pos_x].items = item_stack;
+            current_level->map[player->pos().y][player->pos().x].items = item_stack;
             game_state = ON_MAP;
          }
+         break;
       }
-
-      return 0;
+      default:
+         break;
    }
-   
-   if (game_state == INVENTORY_SCREEN) {
-      if (alphaSelect( k, menu_scroll, false ))
-         return 0;
+   return 0;
+}
 
-      if (k == Keyboard::Escape || k == Keyboard::BackSpace) {
-         game_state = ON_MAP; } else
-      if (k == Keyboard::Numpad2 || k == Keyboard::Down) {
-         selectionDown(); } else
-      if (k == Keyboard::Numpad8 || k == Keyboard::Up) {
-         selectionUp(); } else
-      if (k == Keyboard::PageDown) {
-         selectionPageDown(); } else
-      if (k == Keyboard::PageUp) {
-         selectionPageUp(); } else
-      if (k == Keyboard::Space || k == Keyboard::Return) {
+int inventoryKey( GameCommand cmd )
+{
+   switch (cmd) {
+      case CMD_CANCEL:
+         game_state = ON_MAP;
+         break;
+      case CMD_DOWN: selectionDown(); break;
+      case CMD_UP: selectionUp(); break;
+      case CMD_PAGE_DOWN: selectionPageDown(); break;
+      case CMD_PAGE_UP: selectionPageUp(); break;
+      case CMD_CONFIRM: {
          Item *selected = invSelectedItem();
-         game_state = INVENTORY_SELECT;
-         alt_selection = 0;
-         max_alt_selection = selected->num_actions;
+         if (selected != NULL) {
+            game_state = INVENTORY_SELECT;
+            alt_selection = 0;
+            max_alt_selection = selected->def->num_actions;
+         }
+         break;
       }
-
-      return 0;
+      default:
+         break;
    }
+   return 0;
+}
 
-   if (game_state == INVENTORY_SELECT) {
-      if (alphaSelect( k, 0, true ))
-         return 0;
-
-      if (k == Keyboard::Escape || k == Keyboard::BackSpace) {
-         game_state = INVENTORY_SCREEN; } else
-      if (k == Keyboard::Numpad2 || k == Keyboard::Down) {
-         if (++alt_selection == max_alt_selection) alt_selection = 0; } else
-      if (k == Keyboard::Numpad8 || k == Keyboard::Up) {
-         if (--alt_selection == -1) alt_selection = max_alt_selection - 1; } else
-      if (k == Keyboard::Space || k == Keyboard::Return) {
+int inventorySelectKey( GameCommand cmd )
+{
+   switch (cmd) {
+      case CMD_CANCEL:
+         game_state = INVENTORY_SCREEN;
+         break;
+      case CMD_DOWN:
+         if (++alt_selection == max_alt_selection) alt_selection = 0;
+         break;
+      case CMD_UP:
+         if (--alt_selection == -1) alt_selection = max_alt_selection - 1;
+         break;
+      case CMD_CONFIRM: {
          // Do that Item action
          Item *selected = invRemoveSelected();
          // Most actions require the item to be removed first
@@ -1292,20 +1974,27 @@ int sendKeyToGame( Keyboard::Key k, int mod )
                invReplaceSelected( selected );
          }
          game_state = ON_MAP;
+         break;
       }
-
-
-      return 0;
+      default:
+         break;
    }
+   return 0;
+}
 
-   if (game_state == EQUIP_SCREEN) {
-      if (k == Keyboard::E || k == Keyboard::Escape || k == Keyboard::BackSpace) {
-         game_state = ON_MAP; } else 
-      if (k == Keyboard::Numpad2 || k == Keyboard::Down) {
-         if (++alt_selection == max_alt_selection) alt_selection = 0; } else
-      if (k == Keyboard::Numpad8 || k == Keyboard::Up) {
-         if (--alt_selection == -1) alt_selection = max_alt_selection - 1; } else
-      if (k == Keyboard::Space || k == Keyboard::Return) {
+int equipKey( GameCommand cmd )
+{
+   switch (cmd) {
+      case CMD_CANCEL:
+         game_state = ON_MAP;
+         break;
+      case CMD_DOWN:
+         if (++alt_selection == max_alt_selection) alt_selection = 0;
+         break;
+      case CMD_UP:
+         if (--alt_selection == -1) alt_selection = max_alt_selection - 1;
+         break;
+      case CMD_CONFIRM: {
          Item *retval = player->chassis->removeAny( alt_selection );
          if (retval == NULL) { // Selected <empty>
             game_state = EQUIP_INVENTORY;
@@ -1314,34 +2003,32 @@ int sendKeyToGame( Keyboard::Key k, int mod )
             menu_scroll = 0;
 
          } else {
-            addToInventory( retval );
             writeSystemLog( ">Unequipped:" );
-            writeSystemLog( retval->getNamePadded() );
+            writeSystemLog( retval->getName(), 1 );
+            addToInventory( retval );
          }
+         break;
       }
-
-      return 0;
+      default:
+         break;
    }
+   return 0;
+}
 
-   if (game_state == EQUIP_INVENTORY) {
-      if (alphaSelect( k, menu_scroll, false ))
-         return 0;
-
-      if (k == Keyboard::Escape || k == Keyboard::BackSpace) {
-         game_state = EQUIP_SCREEN; } else
-      if (k == Keyboard::Numpad2 || k == Keyboard::Down) {
-         selectionDown(); } else
-      if (k == Keyboard::Numpad8 || k == Keyboard::Up) {
-         selectionUp(); } else
-      if (k == Keyboard::PageDown) {
-         selectionPageDown(); } else
-      if (k == Keyboard::PageUp) {
-         selectionPageUp(); } else
-      if (k == Keyboard::Space || k == Keyboard::Return) {
-         Item *selected = limitedInvSelectedItem();
+int equipInventoryKey( GameCommand cmd )
+{
+   switch (cmd) {
+      case CMD_CANCEL:
+         game_state = EQUIP_SCREEN;
+         break;
+      case CMD_DOWN: selectionDown(); break;
+      case CMD_UP: selectionUp(); break;
+      case CMD_PAGE_DOWN: selectionPageDown(); break;
+      case CMD_PAGE_UP: selectionPageUp(); break;
+      case CMD_CONFIRM: {
+         Item *selected = player->inventory.take( limitedInvSelectedItem() );
          if (selected != NULL) {
             ItemType slot = player->chassis->getSlot( alt_selection );
-            removeFromInventory( selected );
             int result;
             if (slot == ARM) result = player->chassis->addArm( selected );
             else if (slot == MOUNT) result = player->chassis->addMount( selected );
@@ -1352,57 +2039,79 @@ int sendKeyToGame( Keyboard::Key k, int mod )
          }
 
          game_state = EQUIP_SCREEN;
+         break;
       }
+      default:
+         break;
+   }
+   return 0;
+}
+
+int pickUpCommand()
+{
+   Location &player_loc = current_level->map[player->pos().y][player->pos().x];
+   if (player_loc.items == NULL)
+      return 0;
 
+   writeSystemLog( ">Picked up:" );
 
+   if (player_loc.items->next == NULL) { // Pick up the one item
+      writeSystemLog( player_loc.items->getName(), 1 );
+      addToInventory( player_loc.items );
+      player_loc.items = NULL;
       return 0;
    }
 
-   if (game_state == ON_MAP) {
-      int speed = 0;
+   // Otherwise
+   selection = 0;
+   max_selection = 0;
+   Item *i = item_stack = player_loc.items;
+   stack_selected_prev = NULL;
+   while (i != NULL) { i = i->next; ++max_selection; }
+   game_state = PICK_UP;
+   return 0;
+}
 
-      if (k == Keyboard::E) {
+int mapKey( GameCommand cmd )
+{
+   int speed = 0;
+
+   switch (cmd) {
+      case CMD_EQUIP:
          game_state = EQUIP_SCREEN;
          alt_selection = 0;
          max_alt_selection = player->chassis->getTotalSlots();
          return 0;
-      }
 
-      if (k == Keyboard::I) {
+      case CMD_SAVE:
+         if (saveGame() == 0)
+            writeSystemLog( ">Game saved" );
+         else
+            writeSystemLog( ">ERROR: SAVE FAILED" );
+         return 0;
+
+      case CMD_INVENTORY:
          game_state = INVENTORY_SCREEN;
          selection = 0;
          max_selection = getInventorySize();
          menu_scroll = 0;
          return 0;
-      }
-
-      if (k == Keyboard::Comma) {
-         Location &player_loc = current_level->map[player->pos_y][player->pos_x];
-         if (player_loc.items == NULL)
-            return 0;
 
-         writeSystemLog( ">Picked up:" );
-
-         if (player_loc.items->next == NULL) { // Pick up the one item
-            addToInventory( player_loc.items );
-            writeSystemLog( player_loc.items->getNamePadded() );
-            player_loc.items = NULL;
-            return 0;
+      case CMD_STAIRS_UP:
+      case CMD_STAIRS_DOWN:
+         speed = takeExit( cmd == CMD_STAIRS_UP );
+         if (speed > 0) {
+            addUnitToQueue( player, speed );
+            clearCurrentUnit();
          }
-
-         // Otherwise
-         selection = 0;
-         max_selection = 0;
-         Item *i = item_stack = player_loc.items;
-         stack_selected_prev = NULL;
-         while (i != NULL) { i = i->next; ++max_selection; }
-         game_state = PICK_UP;
          return 0;
-      }
+
+      case CMD_PICK_UP:
+         return pickUpCommand();
 
       // Items
 
-      if (k == Keyboard::F) {
+      case CMD_FIRE:
          if (initTacticalSelection( RANGED_WEAPON ) == -1) {
             writeSystemLog( ">ERROR: NO RANGED" );
             writeSystemLog( " WEAPONRY EQUIPPED" );
@@ -1410,68 +2119,203 @@ int sendKeyToGame( Keyboard::Key k, int mod )
          else
             game_state = SELECTING_ABILITY;
          return 0;
-      }
 
-      // Movement
-      if (k == Keyboard::Numpad1){
-         speed = movePlayer( SOUTHWEST ); } else
-      if (k == Keyboard::Numpad2 || k == Keyboard::Down){
-         speed = movePlayer( SOUTH ); } else
-      if (k == Keyboard::Numpad3){
-         speed = movePlayer( SOUTHEAST ); } else
-      if (k == Keyboard::Numpad4 || k == Keyboard::Left){
-         speed = movePlayer( WEST ); } else
-      if (k == Keyboard::Numpad6 || k == Keyboard::Right){
-         speed = movePlayer( EAST ); } else
-      if (k == Keyboard::Numpad7){
-         speed = movePlayer( NORTHWEST ); } else
-      if (k == Keyboard::Numpad8 || k == Keyboard::Up){
-         speed = movePlayer( NORTH ); } else
-      if (k == Keyboard::Numpad9){
-         speed = movePlayer( NORTHEAST ); }
-
-      addUnitToQueue( player, speed );
-      clearCurrentUnit();
-      return 0;
+      default:
+         break;
    }
 
+   // Movement
+   if (cmd >= CMD_NORTH && cmd <= CMD_NORTHWEST)
+      speed = movePlayer( (Direction) (cmd - CMD_NORTH) );
+
+   addUnitToQueue( player, speed );
+   clearCurrentUnit();
+   return 0;
+}
 
+int ignoreKey( GameCommand cmd )
+{
    return 0;
 }
 
+enum AlphaSelect { NO_ALPHA, ALPHA_MENU, ALPHA_ALT };
+
+struct StateInput
+{
+   int (*handler)( GameCommand cmd );
+   AlphaSelect alpha; // Whether letters pick entries before the keymap is checked
+};
+
+// Indexed by GameState
+const StateInput state_input[NUM_GAME_STATES] = {
+   { mapKey, NO_ALPHA }, // ON_MAP
+   { abilityKey, NO_ALPHA }, // SELECTING_ABILITY
+   { targettingKey, NO_ALPHA }, // TARGETTING
+   { textPauseKey, NO_ALPHA }, // TEXT_PAUSE
+   { inventoryKey, ALPHA_MENU }, // INVENTORY_SCREEN
+   { inventorySelectKey, ALPHA_ALT }, // INVENTORY_SELECT
+   { equipKey, NO_ALPHA }, // EQUIP_SCREEN
+   { equipInventoryKey, ALPHA_MENU }, // EQUIP_INVENTORY
+   { pickUpKey, NO_ALPHA }, // PICK_UP
+   { ignoreKey, NO_ALPHA } // HELP_SCREEN
+};
+
+// Acts on a key the keymap has already resolved to cmd
+int applyKey( Keyboard::Key k, GameCommand cmd )
+{
+   const StateInput &input = state_input[game_state];
+
+   if (input.alpha == ALPHA_MENU && alphaSelect( k, menu_scroll, false ))
+      return 0;
+   if (input.alpha == ALPHA_ALT && alphaSelect( k, 0, true ))
+      return 0;
+
+   return input.handler( cmd );
+}
+
+// Resolves and acts on a key the game is ready for, live or from the queue
+int actOnKey( Keyboard::Key k, int mod )
+{
+   GameCommand cmd = lookupKey( game_state, k, mod );
+
+   // Only keys the game actually acts on matter for a replay
+   recordKey( ticks, k, cmd );
+
+   return applyKey( k, cmd );
+}
+
+int sendKeyToGame( Keyboard::Key k, int mod, bool repeat )
+{
+   if (k == Keyboard::Q && (mod & MOD_SHIFT))
+      shutdown(1, 1);
+
+   if (!waiting_for_input) {
+      if (!input_queue.push( KeyInput(k, mod), repeat ))
+         LOG_DEBUG("Input queue dropped a key");
+      return 1;
+   }
+
+   return actOnKey( k, mod );
+}
+
+bool trackKeyPress( Keyboard::Key k )
+{
+   return input_queue.keyDown( k );
+}
+
+void trackKeyRelease( Keyboard::Key k )
+{
+   input_queue.keyUp( k );
+}
+
+void setInputDepth( int depth )
+{
+   input_queue.setDepth( depth );
+}
+
 int playGame()
 {
    if (waiting_for_input) { // wait for input
-      while (!input_stack.empty() && waiting_for_input) {
-         KeyInput next_input = input_stack.top();
-         input_stack.pop();
-         sendKeyToGame( next_input.k, next_input.mod );
-      }
+      KeyInput next_input;
+      while (waiting_for_input && input_queue.pop( next_input ))
+         actOnKey( next_input.k, next_input.mod );
    }
    else
    {
-      if (current_unit == NULL)
-         current_unit = getNextUnit();
+      Unit *unit = unitHandles().get( current_unit );
+      if (unit == NULL) {
+         runAITurns();
+         unit = getNextUnit();
+      }
+
+      if (unit == NULL) // Nobody left to move
+         return 0;
 
-      if (current_unit == player) {
+      if (unit == player) {
+         doFOV();
+         autosave();
          waiting_for_input = true;
          return 0;
       }
 
-      // TODO: AI goes here
-      int speed = current_unit->takeTurn();
+      // Only a unit left mid-turn, e.g. by loading a game, gets here
+      int speed = unit->takeTurn();
       if (speed == -1) { // Unit is dead
-         delete current_unit;
+         delete unit;
          clearCurrentUnit();
          return 0;
       }
-      addUnitToQueue( current_unit, speed );
+      addUnitToQueue( unit, speed );
       clearCurrentUnit();
 
    }
    return 0;
 }
 
+//////////////////////////////////////////////////////////////////////
+// Replays
+//////////////////////////////////////////////////////////////////////
+
+/* Runs the game from an opened replay (see replay.h) with nothing drawn,
+ * as fast as it will go, and logs the throughput.  Each recorded command is
+ * fed in as soon as the game is ready for input; it should arrive on the
+ * same tick it was recorded on, and if it doesn't the replay has drifted
+ * from the game.
+ */
+int playReplay()
+{
+   newGame();
+
+   sf::Clock clock;
+   unsigned long start_ticks = ticks, start_turns = turns_taken;
+   unsigned long keys = 0;
+   bool drifted = false;
+
+   while (shutdown() == 0) {
+      if (waiting_for_input && input_queue.empty()) {
+         unsigned long tick;
+         int key, cmd;
+         if (!nextReplayKey( tick, key, cmd ))
+            break;
+         if (cmd < 0 || cmd >= NUM_GAME_COMMANDS) {
+            log("Replay stopped: it holds an unknown command", LOG_LEVEL_WARNING);
+            drifted = true;
+            break;
+         }
+
+         if (tick != ticks && !drifted) {
+            std::stringstream ss;
+            ss << "Replay drifted: key recorded at tick " << tick << " arrived at " << ticks;
+            log( ss.str(), LOG_LEVEL_WARNING );
+            drifted = true;
+         }
+
+         applyKey( (Keyboard::Key) key, (GameCommand) cmd );
+         keys++;
+      }
+      else if (!waiting_for_input && current_level->time_queue.empty()
+            && unitHandles().get( current_unit ) == NULL) {
+         log("Replay stopped: nobody left to take a turn", LOG_LEVEL_WARNING);
+         break;
+      }
+
+      playGame();
+   }
+
+   float seconds = clock.getElapsedTime().asSeconds();
+   if (seconds <= 0) seconds = 0.001f;
+
+   unsigned long run_ticks = ticks - start_ticks, run_turns = turns_taken - start_turns;
+   std::stringstream ss;
+   ss << "Replay done: " << keys << " keys, " << run_ticks << " ticks, " << run_turns
+      << " turns in " << seconds << "s (" << (unsigned long) (run_ticks / seconds) << " ticks/sec, "
+      << (unsigned long) (run_turns / seconds) << " turns/sec)";
+   log( ss.str() );
+
+   closeReplay();
+   return drifted ? 1 : 0;
+}
+
 //////////////////////////////////////////////////////////////////////
 // Visuals
 //////////////////////////////////////////////////////////////////////
@@ -1492,34 +2336,44 @@ void drawSystemLog()
    writeString( "+-----------------------+", C_WHITE, C_BLACK, start_col, 27 );
 
    // Log contents
-   std::deque<std::string>::iterator log_it = system_log.begin(), log_end = system_log.end();
-   for (int i = 0; i < system_log_scroll; ++i) {
-      if (log_it == log_end)
-         return;
-
-      ++log_it;
-   }
-
-   for (y = 26; y > 2; --y) {
-      if (log_it == log_end)
-         break;
-
-      writeString( *log_it, C_WHITE, C_BLACK, start_col+1, y );
-      ++log_it;
-   }
+   int line = system_log_scroll;
+   for (y = 26; y > 2 && line < system_log_count; --y, ++line)
+      writeString( systemLogLine( line ), C_WHITE, C_BLACK, start_col+1, y );
 }
 
 // HUD/BottomBar
    
 void drawBottomBar()
 {
-   std::stringstream tick_string;
-   tick_string << "Ticks: " << ticks;
-   writeString( tick_string.str(), C_WHITE, C_BLACK, 5, 29 );
+   writeFormatted( C_WHITE, C_BLACK, 5, 29, "Ticks: %lu", ticks );
 }
 
 // The rest
 
+// Units
+
+/* One pass over the position and look components, rather than asking each
+ * map cell for its unit.  Units are only drawn where they can be seen.
+ */
+void drawUnits( int x_start )
+{
+   UnitComponents &uc = unitComponents();
+   for (unsigned int n = 0; n < uc.size(); ++n) {
+      const Position &p = uc.position[n];
+      if (p.level != current_level || !uc.body[n].alive)
+         continue;
+
+      if (!(current_level->vision_map[p.y][p.x] & MAP_VISIBLE))
+         continue;
+
+      int x = p.x - (int) map_view_base.x, y = p.y - (int) map_view_base.y;
+      if (x < x_start || x >= 55 || y < 0 || y >= 28)
+         continue;
+
+      writeChar( uc.look[n].display_char, C_WHITE, C_BLACK, x, y );
+   }
+}
+
 int displayGame()
 {
    if (current_level == NULL) return -1;
@@ -1551,11 +2405,9 @@ int displayGame()
 
       if (game_state == PICK_UP) {
          x_start = 25;
-         drawItemStack( item_stack, "Pick up:", false, false );
+         drawItemStack( item_stack, "Pick up:", false );
       }
 
-      doFOV();
-
       for (int x = x_start; x < 55; x++) {
          for (int y = 0; y < 28; y++) {
 
@@ -1570,9 +2422,7 @@ int displayGame()
 
             Location &l = current_level->map[map_y][map_x];
 
-            if (l.unit != NULL && visibility & MAP_VISIBLE) {
-               l.unit->drawUnit(x, y);
-            } else if (l.items != NULL) {
+            if (l.items != NULL) {
                l.items->drawItem(x, y);
             } else {
                if (l.ter == FLOOR)
@@ -1590,6 +2440,8 @@ int displayGame()
          }
       }
 
+      drawUnits( x_start );
+
       if (game_state == TARGETTING) {
          int x = reticle.x - map_view_base.x,
              y = reticle.y - map_view_base.y;
@@ -11,16 +11,27 @@
 #include <SFML/Window.hpp>
 #include "structures.h"
 
+#define DEFAULT_SAVE_FILE "save.dat"
+#define AUTOSAVE_FILE "autosave.dat"
+
 void newGame();
-void loadGame();
+int saveGame( const char *path = DEFAULT_SAVE_FILE );
+int loadGame( const char *path = DEFAULT_SAVE_FILE );
 
 void testLevel();
 
-int sendKeyToGame( sf::Keyboard::Key k, int mod=0 );
+// repeat: the key is auto-repeating, see trackKeyPress
+int sendKeyToGame( sf::Keyboard::Key k, int mod=0, bool repeat=false );
+// Call on every key event, in or out of the game; true for an auto-repeat
+bool trackKeyPress( sf::Keyboard::Key k );
+void trackKeyRelease( sf::Keyboard::Key k );
+void setInputDepth( int depth );
 
 int playGame();
 int displayGame();
 
+int playReplay();
+
 // Interface to data
 
 extern Level* current_level;
@@ -36,4 +47,6 @@ int dropFromInventory( Item *i );
 int moveUnit( Unit*, Direction );
 int destroyUnit( Unit* target );
 
+int freeLevelObjects( Level *level );
+
 #endif
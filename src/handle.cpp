@@ -0,0 +1,13 @@
+#include "handle.h"
+
+HandleTable<Unit>& unitHandles()
+{
+   static HandleTable<Unit> table;
+   return table;
+}
+
+HandleTable<Item>& itemHandles()
+{
+   static HandleTable<Item> table;
+   return table;
+}
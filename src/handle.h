@@ -0,0 +1,111 @@
+#ifndef HANDLE_H__
+#define HANDLE_H__
+
+/* Generational handles for Units and Items.
+ *
+ * A Handle is an index into a HandleTable plus the generation that slot
+ * had when the handle was made.  Deleting the object bumps the slot's
+ * generation, so any handle still pointing at it goes stale: get() checks
+ * the generation and returns NULL instead of a dangling pointer.  Freed
+ * slots are reused, and only the table knows where an object actually
+ * lives, so the pools are free to move or recycle memory underneath.
+ *
+ * Index 0 is never handed out, so a default Handle is always null.
+ */
+
+#include <vector>
+#include <cstddef>
+
+struct Handle
+{
+   unsigned int index;
+   unsigned int generation;
+
+   Handle() { index = 0; generation = 0; }
+   Handle( unsigned int i, unsigned int g ) { index = i; generation = g; }
+
+   bool isNull() const { return index == 0; }
+
+   bool operator==( const Handle &rhs ) const { return index == rhs.index && generation == rhs.generation; }
+   bool operator!=( const Handle &rhs ) const { return !(*this == rhs); }
+};
+
+template <class T>
+class HandleTable
+{
+   struct Entry
+   {
+      T *object;
+      unsigned int generation;
+      unsigned int next_free; // 0 = end of free list
+   };
+
+   std::vector<Entry> entries;
+   unsigned int free_head;
+   unsigned int live;
+
+public:
+   HandleTable()
+   {
+      Entry null_entry = { NULL, 0, 0 };
+      entries.push_back( null_entry );
+      free_head = 0;
+      live = 0;
+   }
+
+   Handle add( T *object )
+   {
+      unsigned int index;
+      if (free_head != 0) {
+         index = free_head;
+         free_head = entries[index].next_free;
+      } else {
+         Entry e = { NULL, 0, 0 };
+         index = entries.size();
+         entries.push_back( e );
+      }
+
+      entries[index].object = object;
+      entries[index].next_free = 0;
+      live++;
+      return Handle( index, entries[index].generation );
+   }
+
+   // Invalidates every outstanding copy of h
+   void remove( Handle h )
+   {
+      if (get( h ) == NULL)
+         return;
+
+      Entry &e = entries[h.index];
+      e.object = NULL;
+      e.generation++;
+      e.next_free = free_head;
+      free_head = h.index;
+      live--;
+   }
+
+   // NULL if the object has been deleted since h was made
+   T* get( Handle h ) const
+   {
+      if (h.index == 0 || h.index >= entries.size())
+         return NULL;
+
+      const Entry &e = entries[h.index];
+      if (e.generation != h.generation)
+         return NULL;
+      return e.object;
+   }
+
+   bool valid( Handle h ) const { return get( h ) != NULL; }
+
+   unsigned int size() const { return live; }
+};
+
+struct Unit;
+struct Item;
+
+HandleTable<Unit>& unitHandles();
+HandleTable<Item>& itemHandles();
+
+#endif
@@ -0,0 +1,61 @@
+#include "input.h"
+
+InputQueue::InputQueue( int d, bool c )
+{
+   head = tail = 0;
+   coalesce = c;
+   setDepth( d );
+   for (int i = 0; i < sf::Keyboard::KeyCount; ++i)
+      down[i] = false;
+}
+
+void InputQueue::setDepth( int d )
+{
+   if (d < 1) d = 1;
+   if (d > max_input_depth) d = max_input_depth;
+   depth = d;
+}
+
+bool InputQueue::keyDown( sf::Keyboard::Key k )
+{
+   if (k < 0 || k >= sf::Keyboard::KeyCount)
+      return false;
+
+   bool repeat = down[k];
+   down[k] = true;
+   return repeat;
+}
+
+void InputQueue::keyUp( sf::Keyboard::Key k )
+{
+   if (k >= 0 && k < sf::Keyboard::KeyCount)
+      down[k] = false;
+}
+
+bool InputQueue::push( const KeyInput &key, bool repeat )
+{
+   unsigned int t = tail;
+   if ((int) (t - head) >= depth)
+      return false;
+
+   if (coalesce && repeat && t != head) {
+      const KeyInput &last = keys[(t - 1) % max_input_depth];
+      if (last.k == key.k && last.mod == key.mod)
+         return false;
+   }
+
+   keys[t % max_input_depth] = key;
+   tail = t + 1;
+   return true;
+}
+
+bool InputQueue::pop( KeyInput &key )
+{
+   unsigned int h = head;
+   if (h == tail)
+      return false;
+
+   key = keys[h % max_input_depth];
+   head = h + 1;
+   return true;
+}
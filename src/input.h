@@ -0,0 +1,65 @@
+#ifndef INPUT_H__
+#define INPUT_H__
+
+/* Keys waiting for the game to be ready for them.
+ *
+ * Keys that arrive while the game is busy are buffered here and handed back
+ * in the order they were pressed.  The queue is bounded: once 'depth' keys
+ * are waiting, further keys are dropped rather than piling up behind a long
+ * animation.  The depth can be set with --input-depth <n>.
+ *
+ * With coalescing on, an auto-repeat of a key that's still waiting at the
+ * back of the queue is dropped, so holding down a movement key queues one
+ * step instead of a screenful of them.  A key only counts as repeating if
+ * it hasn't been released since it was last pressed (see keyDown/keyUp), so
+ * tapping the same key twice always queues it twice.  keyDown and keyUp
+ * must only be called from the key event listeners, never when a queued
+ * key is handed back.
+ *
+ * push() only writes 'tail' and pop() only writes 'head', so one thread can
+ * feed the queue while another drains it.  This tree has no atomics, so a
+ * real input thread would still need a memory fence on each index.
+ */
+
+#include <SFML/Window.hpp>
+
+struct KeyInput {
+   sf::Keyboard::Key k;
+   int mod;
+
+   KeyInput() {k = sf::Keyboard::Unknown; mod = 0;}
+   KeyInput( sf::Keyboard::Key kk ) {k = kk; mod = 0;}
+   KeyInput( sf::Keyboard::Key kk, int m ) {k = kk; mod = m;}
+};
+
+const int max_input_depth = 64;
+
+class InputQueue
+{
+   KeyInput keys[max_input_depth];
+   volatile unsigned int head, tail; // keys[head % max] is the oldest
+   int depth;
+   bool coalesce;
+   bool down[sf::Keyboard::KeyCount];
+
+public:
+   InputQueue( int depth = 16, bool coalesce = true );
+
+   void setDepth( int d ); // clamped to [1, max_input_depth]
+   void setCoalescing( bool on ) { coalesce = on; }
+
+   // Track which keys are held; keyDown returns true for an auto-repeat
+   bool keyDown( sf::Keyboard::Key k );
+   void keyUp( sf::Keyboard::Key k );
+
+   // false if the key was dropped
+   bool push( const KeyInput &key, bool repeat = false );
+   // false if there was nothing waiting
+   bool pop( KeyInput &key );
+
+   bool empty() const { return head == tail; }
+   int size() const { return tail - head; }
+   void clear() { head = tail; }
+};
+
+#endif
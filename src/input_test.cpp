@@ -0,0 +1,98 @@
+/* Tests for the input queue.  Built as input_test; run by ctest.
+ */
+
+#include "input.h"
+
+#include <cstdio>
+
+static int failures = 0;
+
+#define CHECK( cond ) \
+   do { if (!(cond)) { printf( "%s:%d: CHECK(%s) failed\n", __FILE__, __LINE__, #cond ); failures++; } } while (0)
+
+using namespace sf;
+
+// Holding a key down queues it once, however many repeats arrive
+void testAutoRepeatCoalesces()
+{
+   InputQueue q( 16, true );
+
+   CHECK( !q.keyDown( Keyboard::Up ) );
+   CHECK( q.push( KeyInput( Keyboard::Up ), false ) );
+   for (int i = 0; i < 5; ++i) {
+      bool repeat = q.keyDown( Keyboard::Up );
+      CHECK( repeat );
+      CHECK( !q.push( KeyInput( Keyboard::Up ), repeat ) );
+   }
+   CHECK( q.size() == 1 );
+}
+
+// Two real taps are two keys, even with the first still queued
+void testTapsAreKept()
+{
+   InputQueue q( 16, true );
+
+   bool repeat = q.keyDown( Keyboard::Up );
+   CHECK( q.push( KeyInput( Keyboard::Up ), repeat ) );
+   q.keyUp( Keyboard::Up );
+
+   repeat = q.keyDown( Keyboard::Up );
+   CHECK( !repeat );
+   CHECK( q.push( KeyInput( Keyboard::Up ), repeat ) );
+   CHECK( q.size() == 2 );
+}
+
+// Draining the queue mustn't make the next tap look like a repeat
+void testTapAfterDrain()
+{
+   InputQueue q( 16, true );
+
+   bool repeat = q.keyDown( Keyboard::Up );
+   q.keyUp( Keyboard::Up );
+   CHECK( q.push( KeyInput( Keyboard::Up ), repeat ) );
+
+   KeyInput key;
+   CHECK( q.pop( key ) );
+   CHECK( key.k == Keyboard::Up );
+   CHECK( q.empty() );
+
+   // Queued again while the game is busy, with a copy still waiting
+   repeat = q.keyDown( Keyboard::Up );
+   CHECK( !repeat );
+   CHECK( q.push( KeyInput( Keyboard::Up ), repeat ) );
+   q.keyUp( Keyboard::Up );
+
+   repeat = q.keyDown( Keyboard::Up );
+   CHECK( !repeat );
+   CHECK( q.push( KeyInput( Keyboard::Up ), repeat ) );
+   CHECK( q.size() == 2 );
+}
+
+void testDepth()
+{
+   InputQueue q( 2, false );
+
+   CHECK( q.push( KeyInput( Keyboard::A ) ) );
+   CHECK( q.push( KeyInput( Keyboard::B ) ) );
+   CHECK( !q.push( KeyInput( Keyboard::C ) ) );
+
+   q.setDepth( 0 );
+   q.clear();
+   CHECK( q.push( KeyInput( Keyboard::A ) ) );
+   CHECK( !q.push( KeyInput( Keyboard::B ) ) );
+}
+
+int main()
+{
+   testAutoRepeatCoalesces();
+   testTapsAreKept();
+   testTapAfterDrain();
+   testDepth();
+
+   if (failures > 0) {
+      printf( "%d input checks failed\n", failures );
+      return 1;
+   }
+   printf( "All input checks passed\n" );
+   return 0;
+}
@@ -0,0 +1,193 @@
+#include "inventory.h"
+#include "log.h"
+#include "pool.h"
+
+#include <algorithm>
+
+void Inventory::renumberFrom( int n )
+{
+   for (int i = n; i < (int) items.size(); ++i)
+      items[i]->inv_index = i;
+}
+
+static bool invOrder( Item *a, Item *b )
+{
+   return a->inv_index < b->inv_index;
+}
+
+static ItemSpan spanOf( std::vector<Item*> &v )
+{
+   if (v.empty())
+      return ItemSpan();
+   return ItemSpan( &v[0], v.size() );
+}
+
+// Buckets are sorted by inv_index, so an item's place is a binary search
+static void bucketInsert( std::vector<Item*> &bucket, Item *item )
+{
+   bucket.insert( std::lower_bound( bucket.begin(), bucket.end(), item, invOrder ), item );
+}
+
+static void bucketErase( std::vector<Item*> &bucket, Item *item )
+{
+   std::vector<Item*>::iterator it =
+      std::lower_bound( bucket.begin(), bucket.end(), item, invOrder );
+   if (it != bucket.end() && *it == item)
+      bucket.erase( it );
+   else
+      log("Inventory bucket is out of step with the inventory", LOG_LEVEL_ERROR);
+}
+
+static bool canStack( Item *a, Item *b )
+{
+   return a->def == b->def
+       && a->def->type != CHASSIS
+       && a->durability == a->def->max_durability && a->rearm_time == 0
+       && b->durability == b->def->max_durability && b->rearm_time == 0;
+}
+
+// Call with item->inv_index already set
+void Inventory::fileItem( Item *item )
+{
+   bucketInsert( type_buckets[item->def->type], item );
+   bucketInsert( weapon_buckets[item->def->weapon_type], item );
+}
+
+// Call before item->inv_index changes
+void Inventory::unfileItem( Item *item )
+{
+   bucketErase( type_buckets[item->def->type], item );
+   bucketErase( weapon_buckets[item->def->weapon_type], item );
+}
+
+Item* Inventory::findStackFor( Item *item )
+{
+   std::vector<Item*> &bucket = type_buckets[item->def->type];
+   for (unsigned int i = 0; i < bucket.size(); ++i) {
+      if (canStack( bucket[i], item ))
+         return bucket[i];
+   }
+   return NULL;
+}
+
+Item* Inventory::at( int n ) const
+{
+   if (n < 0 || n >= (int) items.size())
+      return NULL;
+   return items[n];
+}
+
+bool Inventory::contains( Item *item ) const
+{
+   if (item == NULL)
+      return false;
+
+   int n = item->inv_index;
+   return n >= 0 && n < (int) items.size() && items[n] == item;
+}
+
+int Inventory::add( Item *item )
+{
+   return insert( items.size(), item );
+}
+
+int Inventory::insert( int n, Item *item )
+{
+   if (item == NULL) {
+      log("Inventory can't add item, item is NULL", LOG_LEVEL_ERROR);
+      return -1;
+   }
+   if (contains( item )) {
+      log("Inventory can't add item, it's already there", LOG_LEVEL_ERROR);
+      return -2;
+   }
+
+   Item *stack = findStackFor( item );
+   if (stack != NULL) {
+      stack->count += item->count;
+      delete item;
+      return 0;
+   }
+
+   if (n < 0) n = 0;
+   if (n > (int) items.size()) n = items.size();
+
+   item->next = NULL;
+   items.insert( items.begin() + n, item );
+   renumberFrom( n );
+   fileItem( item );
+   return 0;
+}
+
+int Inventory::remove( Item *item )
+{
+   if (!contains( item ))
+      return -2;
+
+   removeAt( item->inv_index );
+   return 0;
+}
+
+Item* Inventory::removeAt( int n )
+{
+   Item *item = at( n );
+   if (item == NULL)
+      return NULL;
+
+   unfileItem( item );
+   items.erase( items.begin() + n );
+   item->inv_index = -1;
+   renumberFrom( n );
+   return item;
+}
+
+Item* Inventory::take( Item *item )
+{
+   if (!contains( item ))
+      return NULL;
+
+   return takeAt( item->inv_index );
+}
+
+Item* Inventory::takeAt( int n )
+{
+   Item *stack = at( n );
+   if (stack == NULL)
+      return NULL;
+
+   if (stack->count <= 1)
+      return removeAt( n );
+
+   // A stack is all pristine copies, so a fresh item is an exact match
+   Item *single = createItem( stack->def->kind );
+   ObjectPool::setArena( single, ObjectPool::getArena( stack ) );
+   stack->count--;
+   return single;
+}
+
+void Inventory::clear()
+{
+   for (unsigned int i = 0; i < items.size(); ++i)
+      items[i]->inv_index = -1;
+   items.clear();
+
+   for (int t = 0; t < NUM_ITEM_TYPES; ++t)
+      type_buckets[t].clear();
+   for (int t = 0; t < NUM_WEAPON_TYPES; ++t)
+      weapon_buckets[t].clear();
+}
+
+ItemSpan Inventory::all()
+{
+   return spanOf( items );
+}
+
+ItemSpan Inventory::ofType( ItemType type )
+{
+   return spanOf( type_buckets[type] );
+}
+
+ItemSpan Inventory::ofWeaponType( WeaponType type )
+{
+   return spanOf( weapon_buckets[type] );
+}
@@ -0,0 +1,74 @@
+#ifndef INVENTORY_H__
+#define INVENTORY_H__
+
+/* A unit's carried items.
+ *
+ * Items are kept in one packed array in pick-up order, and each Item
+ * remembers its own position (inv_index), so the size, the n'th item and
+ * "is this item here" are all O(1).  Removing an item closes the gap and
+ * renumbers the items after it.  The Item pointer is the handle: items are
+ * never moved or copied, so a pointer stays good for as long as the item
+ * is carried, whatever else is picked up or dropped.
+ *
+ * Every item is also filed in a bucket for its ItemType and one for its
+ * WeaponType, each kept in inventory order.  Adding and removing keep the
+ * buckets up to date, so the filtered lists behind the equip, use and fire
+ * screens are ready without a scan.
+ *
+ * Identical, undamaged items stack: adding one that matches an entry
+ * already here just bumps that entry's count and deletes the new Item, so
+ * twenty claw arms are one Item and one row.  take() splits a single item
+ * back off a stack when one is actually needed, and removeAt() lifts out
+ * a whole stack.  Anything that isn't pristine never stacks.
+ *
+ * The inventory doesn't own its items; whoever takes one out is
+ * responsible for it.
+ */
+
+#include "items.h"
+
+#include <vector>
+
+class Inventory
+{
+   std::vector<Item*> items;
+   std::vector<Item*> type_buckets[NUM_ITEM_TYPES];
+   std::vector<Item*> weapon_buckets[NUM_WEAPON_TYPES];
+
+   void renumberFrom( int n );
+   void fileItem( Item *item );
+   void unfileItem( Item *item );
+   Item* findStackFor( Item *item );
+
+public:
+   int size() const { return items.size(); }
+   bool empty() const { return items.empty(); }
+
+   // NULL if n is out of range
+   Item* at( int n ) const;
+   Item* operator[]( int n ) const { return at( n ); }
+
+   bool contains( Item *item ) const;
+
+   // Either of these may merge item into a stack and delete it, so don't
+   // touch item afterwards
+   int add( Item *item );
+   int insert( int n, Item *item );
+
+   // Whole entries, stack and all
+   int remove( Item *item );
+   Item* removeAt( int n );
+
+   // Exactly one item, split off the entry if it's a stack
+   Item* take( Item *item );
+   Item* takeAt( int n );
+
+   void clear();
+
+   // Spans over the inventory itself, invalidated by the next add or remove
+   ItemSpan all();
+   ItemSpan ofType( ItemType type );
+   ItemSpan ofWeaponType( WeaponType type );
+};
+
+#endif
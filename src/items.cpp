@@ -5,25 +5,41 @@
 #include "syslog.h"
 #include "units.h"
 #include "defs.h"
-
-#include <sstream>
+#include "pool.h"
+#include "random.h"
+#include "combat.h"
 
 using namespace sf;
 
-void Item::initBasics() {
-   weapon_type = NOT_A_WEAPON;
+Item::Item( ItemKind kind )
+{
+   handle = itemHandles().add( this );
+   def = &item_defs[kind];
+   durability = def->max_durability;
    rearm_time = 0;
-   targetted = false;
-   alt_next = NULL;
    next = NULL;
+   inv_index = -1;
+   count = 1;
+}
+
+Item* createItem( ItemKind kind )
+{
+   if (kind == LASER)
+      return new Laser();
+
+   if (item_defs[kind].type == CHASSIS)
+      return new Chassis( kind );
+
+   return new Item( kind );
 }
 
 void Item::drawItem( int x, int y ) {
-   writeChar( display_char, C_WHITE, C_BLACK, x, y );
+   writeChar( def->display_char, C_WHITE, C_BLACK, x, y );
 }
 
 /* Generic Items have only one action:
  * a)Drop
+ * Arms add b)Equip (Arm), and Mounts can be equipped either way.
  */
 
 int Item::drawActions()
@@ -36,45 +52,94 @@ int Item::drawActions()
    writeString( "a)", C_GRAY, C_BLACK, actions_header_column, row);
    writeString( "Drop", C_WHITE, C_BLACK, actions_column, row );
 
-   return num_actions;
+   if (def->type == ARM) {
+      row++;
+      writeString( "b)", C_GRAY, C_BLACK, actions_header_column, row);
+      writeString( "Equip (Arm)", C_WHITE, C_BLACK, actions_column, row );
+   }
+   else if (def->type == MOUNT) {
+      row++;
+      writeString( "b)", C_GRAY, C_BLACK, actions_header_column, row);
+      writeString( "Equip (Mount)", C_WHITE, C_BLACK, actions_column, row );
+      row++;
+      writeString( "c)", C_GRAY, C_BLACK, actions_header_column, row);
+      writeString( "Equip (Arm)", C_WHITE, C_BLACK, actions_column, row );
+   }
+
+   return def->num_actions;
 }
 
 int Item::doAction( int selection )
 {
-   if (selection != 0) return -1;
+   if (selection == 0) {
+      dropItem( this );
+      return 0;
+   }
 
-   dropItem( this );
-   return 0;
+   // With no chassis an equip action does nothing, but isn't a failure
+   Chassis* ch = player->chassis;
+
+   if (def->type == ARM && selection == 1)
+      return (ch == NULL || ch->addArm( this ) == 0) ? 0 : -1;
+
+   if (def->type == MOUNT && selection == 1)
+      return (ch == NULL || ch->addMount( this ) == 0) ? 0 : -1;
+
+   if (def->type == MOUNT && selection == 2)
+      return (ch == NULL || ch->addArm( this ) == 0) ? 0 : -1;
+
+   return -1;
 }
 
 void Item::drawDescription()
 {
    writeString( getName(), C_WHITE, C_BLACK, desc_col, 2 );
+
+   for (int i = 0; def->description[i] != NULL; ++i)
+      writeString( def->description[i], C_WHITE, C_BLACK, desc_col, 4 + i );
 }
 
-int Item::meleeAttack( Unit *target )
+int Item::meleeAttack( Unit *attacker, Unit *target )
 {
-   // By default, can't melee attack 
-   return -1;
+   // By default, only melee weapons can melee attack
+   if (def->weapon_type != MELEE_WEAPON)
+      return -1;
+
+   return genericMeleeAttack( attacker, target, def->dmg_base, def->dmg_variation, def->attack_flags );
 }
 
-int Item::genericMeleeAttack( Unit *target, int dmg_base, int dmg_variation, int flags )
+static CombatEvent startCombatEvent( Item *weapon, Unit *attacker, Unit *target, int flags )
+{
+   CombatEvent event;
+   event.tick = ticks;
+   if (attacker != NULL)
+      event.attacker = attacker->handle;
+   event.target = target->handle;
+   event.weapon = weapon->def;
+   event.target_item = NULL;
+   event.damage = 0;
+   event.flags = flags;
+   return event;
+}
+
+int Item::genericMeleeAttack( Unit *attacker, Unit *target, int dmg_base, int dmg_variation, int flags )
 {
    if (target == NULL) {
-      log("Tried to attack a NULL target");
+      log("Tried to attack a NULL target", LOG_LEVEL_ERROR);
       return -1;
    }
 
-   writeSystemLog( getNamePadded( 1, '-' ) );
+   CombatEvent event = startCombatEvent( this, attacker, target, COMBAT_MELEE );
 
    if ( rearm_time > ticks ) {
-      writeSystemLog( " is disabled." );
-
+      event.flags |= COMBAT_REARMING;
+      recordCombatEvent( event );
       return 0;
    }
 
-   if ((rand() % 4) == 3) {
-      writeSystemLog( " fails to connect." );
+   if (rng( COMBAT_RNG ).oneIn( 4 )) {
+      event.flags |= COMBAT_MISSED;
+      recordCombatEvent( event );
       return 0;
    }
 
@@ -84,79 +149,74 @@ int Item::genericMeleeAttack( Unit *target, int dmg_base, int dmg_variation, int
    else
       item_target = target->chassis->selectRandomItem();
 
-   int damage = dmg_base + (rand() % dmg_variation);
+   int damage = dmg_base;
+   if (dmg_variation > 0)
+      damage += rng( COMBAT_RNG ).below( dmg_variation );
 
-   if (!( flags & MELEE_PIERCING ))
-      damage -= item_target->armor;
+   if ( flags & MELEE_PIERCING )
+      event.flags |= COMBAT_PIERCING;
+   else
+      damage -= item_target->def->armor;
 
    item_target->durability -= damage;
 
-   if (item_target->durability <= 0) {
-
-      if ( flags & MELEE_PIERCING )
-         writeSystemLog( " pierces and destroys" );
-      else
-         writeSystemLog( " hits and destroys" );
+   event.target_item = item_target->def;
+   event.damage = damage;
 
+   if (item_target->durability <= 0) {
+      event.flags |= COMBAT_DESTROYED;
 
-      writeSystemLog( item_target->getNamePadded() );
       if (item_target == target->chassis) {
          // target destroyed
+         event.flags |= COMBAT_KILLED;
+         recordCombatEvent( event );
          destroyUnit( target );
          return 1;
       }
-      else
-      {
-         target->destroyEquipment( item_target );
-      }
+
+      recordCombatEvent( event );
+      target->destroyEquipment( item_target );
    }
    else
    {
       if ( flags & MELEE_DISABLING ) {
-         if ( flags & MELEE_PIERCING )
-            writeSystemLog( " pierces and disables" );
-         else
-            writeSystemLog( " hits and disables" );
-
+         event.flags |= COMBAT_DISABLED;
          item_target->rearm_time = ticks + 3000;
       }
-      else
-      {
-         if ( flags & MELEE_PIERCING )
-            writeSystemLog( " pierces and damages" );
-         else
-            writeSystemLog( " hits and damages" );
-      }
 
-      writeSystemLog( item_target->getNamePadded() );
+      recordCombatEvent( event );
    }
 
    return 0;
 }
 
-int Item::rangedAttack( Unit *target )
+int Item::rangedAttack( Unit *attacker, Unit *target )
 {
-   // By default, can't ranged attack 
-   return -1;
+   // By default, only ranged weapons can ranged attack
+   if (def->weapon_type != RANGED_WEAPON)
+      return -1;
+
+   return genericRangedAttack( attacker, target, def->dmg_base, def->dmg_variation, def->attack_flags );
 }
 
-int Item::genericRangedAttack( Unit *target, int dmg_base, int dmg_variation, int flags )
+int Item::genericRangedAttack( Unit *attacker, Unit *target, int dmg_base, int dmg_variation, int flags )
 {
    if (target == NULL) {
-      log("Tried to shoot a NULL target");
+      log("Tried to shoot a NULL target", LOG_LEVEL_ERROR);
       return -1;
    }
 
-   writeSystemLog( getNamePadded( 1, '>' ) );
+   CombatEvent event = startCombatEvent( this, attacker, target, COMBAT_RANGED );
 
    if ( rearm_time > ticks ) {
-      writeSystemLog( " cannot fire yet." );
-
+      event.flags |= COMBAT_REARMING;
+      recordCombatEvent( event );
       return 0;
    }
 
-   if ((rand() % 4) == 3) {
-      writeSystemLog( " misses." );
+   if (rng( COMBAT_RNG ).oneIn( 4 )) {
+      event.flags |= COMBAT_MISSED;
+      recordCombatEvent( event );
       return 0;
    }
 
@@ -166,336 +226,209 @@ int Item::genericRangedAttack( Unit *target, int dmg_base, int dmg_variation, in
    else
       item_target = target->chassis->selectRandomItem();
 
-   int damage = dmg_base + (rand() % dmg_variation);
-   damage -= item_target->armor;
+   int damage = dmg_base;
+   if (dmg_variation > 0)
+      damage += rng( COMBAT_RNG ).below( dmg_variation );
+   damage -= item_target->def->armor;
 
    item_target->durability -= damage;
 
-   if (item_target->durability <= 0) {
-
-      writeSystemLog( " shoots and destroys" );
+   event.target_item = item_target->def;
+   event.damage = damage;
 
+   if (item_target->durability <= 0) {
+      event.flags |= COMBAT_DESTROYED;
 
-      writeSystemLog( item_target->getNamePadded() );
       if (item_target == target->chassis) {
          // target destroyed
+         event.flags |= COMBAT_KILLED;
+         recordCombatEvent( event );
          destroyUnit( target );
          return 1;
       }
-      else
-      {
-         target->destroyEquipment( item_target );
-      }
+
+      recordCombatEvent( event );
+      target->destroyEquipment( item_target );
    }
    else
    {
       if ( flags & RANGED_DISABLING ) {
-         writeSystemLog( " shoots and disables" );
-
+         event.flags |= COMBAT_DISABLED;
          item_target->rearm_time = ticks + 3000;
       }
-      else
-      {
-         writeSystemLog( " shoots and damages" );
-      }
 
-      writeSystemLog( item_target->getNamePadded() );
+      recordCombatEvent( event );
    }
 
    return 0;
 }
 
-std::string Item::getNamePadded( int num, char pad )
+void* Item::operator new( size_t size )
 {
-   std::string padding( num, pad );
-   return padding + getName();
+   return itemPool().allocate( size );
+}
+
+void Item::operator delete( void *p )
+{
+   ObjectPool::release( p );
 }
 
 Item::~Item()
-{ }
+{
+   itemHandles().remove( handle );
+}
 
 //////////////////////////////////////////////////////////////////////
 // Chassis
 //////////////////////////////////////////////////////////////////////
 
-Item* Chassis::removeAll()
+Chassis::Chassis( ItemKind kind ) : Item( kind )
 {
-   Item *stack = getAllItems();
+   if (getTotalSlots() > MAX_CHASSIS_SLOTS)
+      log("Chassis def has more slots than MAX_CHASSIS_SLOTS", LOG_LEVEL_ERROR);
 
-   arms = NULL;
-   mounts = NULL;
-   systems = NULL;
+   for (int i = 0; i < MAX_CHASSIS_SLOTS; ++i)
+      slots[i] = NULL;
 
-   return stack;
+   rebuildIndexes();
 }
 
-Item* Chassis::getAllItems()
+void Chassis::drawDescription()
 {
-   Item *alt_stack = NULL, *alt_stack_last = NULL;
-   Item *stack = NULL;
-
-   if (arms != NULL) {
-      stack = arms;
-      while (stack != NULL) {
-         if (alt_stack == NULL)
-            alt_stack = alt_stack_last = stack;
-         else {
-            alt_stack_last->alt_next = stack;
-            alt_stack_last = stack;
-         }
-         stack = stack->next;
-      }
-   }
+   Item::drawDescription();
 
-   if (mounts != NULL) {
-      stack = mounts;
-      while (stack != NULL) {
-         if (alt_stack == NULL)
-            alt_stack = alt_stack_last = stack;
-         else {
-            alt_stack_last->alt_next = stack;
-            alt_stack_last = stack;
-         }
-         stack = stack->next;
-      }
-   }
-
-   if (systems != NULL) {
-      stack = systems;
-      while (stack != NULL) {
-         if (alt_stack == NULL)
-            alt_stack = alt_stack_last = stack;
-         else {
-            alt_stack_last->alt_next = stack;
-            alt_stack_last = stack;
-         }
-         stack = stack->next;
-      }
-   }
+   int lines = 0;
+   while (def->description[lines] != NULL)
+      lines++;
 
-   return alt_stack;
+   drawChassisStats( 5 + lines );
 }
 
-Item* Chassis::getAllMelee()
+void Chassis::drawEquipScreen( int selection )
 {
-   Item *alt_stack = NULL, *alt_stack_end = NULL;
-
-   Item *next_item = NULL;
-
-   // All melee weapons are in the arm slot
-   if (arms != NULL) {
-      next_item = arms;
-      while (next_item != NULL) {
-         if (next_item->weapon_type == MELEE_WEAPON) {
-            if (alt_stack == NULL)
-               alt_stack = alt_stack_end = next_item;
-            else {
-               alt_stack_end->alt_next = next_item;
-               alt_stack_end = next_item;
-            }
-         }
-         next_item = next_item->next;
-      }
+   if (def->equip_art != NULL) {
+      for (int i = 0; def->equip_art[i] != NULL; ++i)
+         writeString( def->equip_art[i], C_WHITE, C_BLACK, 0, 2 + i );
    }
 
-   if (alt_stack_end != NULL)
-      alt_stack_end->alt_next = NULL;
-
-   return alt_stack;
+   listEquipment( selection );
 }
 
-Item* Chassis::getAllRanged()
+int Chassis::firstSlot( ItemType slot_type )
 {
-   Item *alt_stack = NULL, *alt_stack_end = NULL;
-
-   Item *next_item = NULL;
-
-   // All ranged weapons are in the arm or mount slot
-   if (arms != NULL) {
-      next_item = arms;
-      while (next_item != NULL) {
-         if (next_item->weapon_type == RANGED_WEAPON) {
-            if (alt_stack == NULL)
-               alt_stack = alt_stack_end = next_item;
-            else {
-               alt_stack_end->alt_next = next_item;
-               alt_stack_end = next_item;
-            }
-         }
-         next_item = next_item->next;
-      }
-   }
-   if (mounts != NULL) {
-      next_item = mounts;
-      while (next_item != NULL) {
-         if (next_item->weapon_type == RANGED_WEAPON) {
-            if (alt_stack == NULL)
-               alt_stack = alt_stack_end = next_item;
-            else {
-               alt_stack_end->alt_next = next_item;
-               alt_stack_end = next_item;
-            }
-         }
-         next_item = next_item->next;
-      }
-   }
+   if (slot_type == ARM)
+      return 0;
+   if (slot_type == MOUNT)
+      return def->num_arms;
+   return def->num_arms + def->num_mounts;
+}
 
-   if (alt_stack_end != NULL)
-      alt_stack_end->alt_next = NULL;
+int Chassis::numSlots( ItemType slot_type )
+{
+   if (slot_type == ARM)
+      return def->num_arms;
+   if (slot_type == MOUNT)
+      return def->num_mounts;
+   return def->num_systems;
+}
 
-   return alt_stack;
+void Chassis::addToIndex( EquipIndex which, int slot )
+{
+   index[which][index_count[which]++] = (unsigned char) slot;
 }
 
-Item* Chassis::getAllTactical()
+void Chassis::rebuildIndexes()
 {
-   Item *alt_stack = NULL, *alt_stack_end = NULL;
-
-   Item *next_item = NULL;
-
-   // Tactical weapons can be in any slot
-   if (arms != NULL) {
-      next_item = arms;
-      while (next_item != NULL) {
-         if (next_item->weapon_type == TACTICAL_WEAPON) {
-            if (alt_stack == NULL)
-               alt_stack = alt_stack_end = next_item;
-            else {
-               alt_stack_end->alt_next = next_item;
-               alt_stack_end = next_item;
-            }
-         }
-         next_item = next_item->next;
-      }
-   }
-   if (mounts != NULL) {
-      next_item = mounts;
-      while (next_item != NULL) {
-         if (next_item->weapon_type == TACTICAL_WEAPON) {
-            if (alt_stack == NULL)
-               alt_stack = alt_stack_end = next_item;
-            else {
-               alt_stack_end->alt_next = next_item;
-               alt_stack_end = next_item;
-            }
-         }
-         next_item = next_item->next;
-      }
-   }
-   if (systems != NULL) {
-      next_item = systems;
-      while (next_item != NULL) {
-         if (next_item->weapon_type == TACTICAL_WEAPON) {
-            if (alt_stack == NULL)
-               alt_stack = alt_stack_end = next_item;
-            else {
-               alt_stack_end->alt_next = next_item;
-               alt_stack_end = next_item;
-            }
-         }
-         next_item = next_item->next;
+   for (int i = 0; i < NUM_EQUIP_INDEXES; ++i)
+      index_count[i] = 0;
+
+   int total = getTotalSlots();
+   if (total > MAX_CHASSIS_SLOTS)
+      total = MAX_CHASSIS_SLOTS;
+
+   for (int i = 0; i < total; ++i) {
+      Item *item = slots[i];
+      if (item == NULL)
+         continue;
+
+      addToIndex( ALL_EQUIPMENT, i );
+
+      ItemType slot_type = getSlot( i );
+      switch (item->def->weapon_type) {
+         case MELEE_WEAPON:
+            // All melee weapons are in the arm slot
+            if (slot_type == ARM)
+               addToIndex( MELEE_EQUIPMENT, i );
+            break;
+         case RANGED_WEAPON:
+            // All ranged weapons are in the arm or mount slot
+            if (slot_type == ARM || slot_type == MOUNT)
+               addToIndex( RANGED_EQUIPMENT, i );
+            break;
+         case TACTICAL_WEAPON:
+            // Tactical weapons can be in any slot
+            addToIndex( TACTICAL_EQUIPMENT, i );
+            break;
+         default:
+            addToIndex( NON_WEAPON_EQUIPMENT, i );
+            break;
       }
    }
+}
+
+ItemSpan Chassis::removeAll( Item **buffer )
+{
+   ItemSpan all = getAllItems();
+   for (int i = 0; i < all.count; ++i)
+      buffer[i] = all[i];
+
+   for (int i = 0; i < MAX_CHASSIS_SLOTS; ++i)
+      slots[i] = NULL;
 
-   if (alt_stack_end != NULL)
-      alt_stack_end->alt_next = NULL;
+   rebuildIndexes();
 
-   return alt_stack;
+   return ItemSpan( buffer, all.count );
 }
 
-Item* Chassis::getAllNonWeapon()
+// Puts item in the first free slot of the given type, -1 if they're all full
+int Chassis::equip( Item *item, ItemType slot_type )
 {
-   Item *alt_stack = NULL, *alt_stack_end = NULL;
-
-   Item *next_item = NULL;
-
-   // Tactical weapons can be in any slot
-   if (arms != NULL) {
-      next_item = arms;
-      while (next_item != NULL) {
-         if (next_item->weapon_type >= USABLE_WEAPON) {
-            if (alt_stack == NULL)
-               alt_stack = alt_stack_end = next_item;
-            else {
-               alt_stack_end->alt_next = next_item;
-               alt_stack_end = next_item;
-            }
-         }
-         next_item = next_item->next;
-      }
-   }
-   if (mounts != NULL) {
-      next_item = mounts;
-      while (next_item != NULL) {
-         if (next_item->weapon_type >= USABLE_WEAPON) {
-            if (alt_stack == NULL)
-               alt_stack = alt_stack_end = next_item;
-            else {
-               alt_stack_end->alt_next = next_item;
-               alt_stack_end = next_item;
-            }
-         }
-         next_item = next_item->next;
-      }
-   }
-   if (systems != NULL) {
-      next_item = systems;
-      while (next_item != NULL) {
-         if (next_item->weapon_type >= USABLE_WEAPON) {
-            if (alt_stack == NULL)
-               alt_stack = alt_stack_end = next_item;
-            else {
-               alt_stack_end->alt_next = next_item;
-               alt_stack_end = next_item;
-            }
-         }
-         next_item = next_item->next;
+   int first = firstSlot( slot_type ), end = first + numSlots( slot_type );
+   for (int i = first; i < end; ++i) {
+      if (slots[i] == NULL) {
+         slots[i] = item;
+         rebuildIndexes();
+         writeSystemLog( ">Equipped:" );
+         writeSystemLog( item->getName(), 1 );
+         return 0;
       }
    }
-
-   if (alt_stack_end != NULL)
-      alt_stack_end->alt_next = NULL;
-
-   return alt_stack;
+   return -1;
 }
 
 int Chassis::addArm( Item* arm )
 {
    int retval = 0;
    if (arm == NULL) {
-      log("Chassis can't add arm, arm is NULL");
+      log("Chassis can't add arm, arm is NULL", LOG_LEVEL_ERROR);
       retval = -2;
    }
    else if (arm->next != NULL) {
-      log("Chassis can't add arm, arm has a next Item* attached");
+      log("Chassis can't add arm, arm has a next Item* attached", LOG_LEVEL_ERROR);
       retval = -3;
    }
-   else if (arm->type != ARM && arm->type != MOUNT) {
-      log("Chassis can't add arm, as it is not an arm item");
+   else if (arm->def->type != ARM && arm->def->type != MOUNT) {
+      log("Chassis can't add arm, as it is not an arm item", LOG_LEVEL_ERROR);
       retval = -4;
-   } else if (arms == NULL && num_arms > 0) {
-      arms = arm;
-      writeSystemLog( ">Equipped:" );
-      writeSystemLog( arm->getNamePadded() );
+   }
+   else if (equip( arm, ARM ) == 0) {
       return 0;
    }
    else
    { 
-      int count = 1;
-      Item *cur = arms;
-      while( count < num_arms ) {
-         if (cur->next == NULL) { // Slot in here
-            cur->next = arm;
-            writeSystemLog( ">Equipped:" );
-            writeSystemLog( arm->getNamePadded() );
-            return 0;
-         }
-         cur = cur->next;
-         count++;
-      }
-
       // No space
       writeSystemLog( ">ERROR: CANNOT EQUIP" );
-      writeSystemLog( arm->getNamePadded() );
+      writeSystemLog( arm->getName(), 1 );
       writeSystemLog( " ARM SLOTS AT CAPACITY" );
       retval = -1;
    }
@@ -507,44 +440,29 @@ int Chassis::addMount( Item* mount )
 {
    int retval = 0;
    if (mount == NULL) {
-      log("Chassis can't add mount, mount is NULL");
-      retval = -2;
+      log("Chassis can't add mount, mount is NULL", LOG_LEVEL_ERROR);
+      return -2;
    }
    else if (mount->next != NULL) {
-      log("Chassis can't add mount, mount has a next Item* attached");
+      log("Chassis can't add mount, mount has a next Item* attached", LOG_LEVEL_ERROR);
       retval = -3;
    }
-   else if (mount->type != MOUNT) {
-      log("Chassis can't add mount, as it is not a mount item");
+   else if (mount->def->type != MOUNT) {
+      log("Chassis can't add mount, as it is not a mount item", LOG_LEVEL_ERROR);
       retval = -4;
-   } else if (mounts == NULL && num_mounts > 0) {
-      mounts = mount;
-      writeSystemLog( ">Equipped:" );
-      writeSystemLog( mount->getNamePadded() );
+   }
+   else if (equip( mount, MOUNT ) == 0) {
       return 0;
    }
    else
-   { 
-      int count = 1;
-      Item *cur = mounts;
-      while( count < num_mounts ) {
-         if (cur->next == NULL) { // Slot in here
-            cur->next = mount;
-            writeSystemLog( ">Equipped:" );
-            writeSystemLog( mount->getNamePadded() );
-            return 0;
-         }
-         cur = cur->next;
-         count++;
-      }
-
+   {
       // No space
-      log("Chassis can't add mount, no more mount slots");
+      log("Chassis can't add mount, no more mount slots", LOG_LEVEL_ERROR);
       retval = -1;
    }
 
    writeSystemLog( ">Unable to equip:" );
-   writeSystemLog( mount->getNamePadded() );
+   writeSystemLog( mount->getName(), 1 );
 
    return retval;
 }
@@ -553,188 +471,97 @@ int Chassis::addSystem( Item* system )
 {
    int retval = 0;
    if (system == NULL) {
-      log("Chassis can't add system, system is NULL");
-      retval = -2;
+      log("Chassis can't add system, system is NULL", LOG_LEVEL_ERROR);
+      return -2;
    }
    else if (system->next != NULL) {
-      log("Chassis can't add system, system has a next Item* attached");
+      log("Chassis can't add system, system has a next Item* attached", LOG_LEVEL_ERROR);
       retval = -3;
    }
-   else if (system->type != SYSTEM) {
-      log("Chassis can't add system, as it is not a system item");
+   else if (system->def->type != SYSTEM) {
+      log("Chassis can't add system, as it is not a system item", LOG_LEVEL_ERROR);
       retval = -4;
-   } else if (systems == NULL && num_systems > 0) {
-      systems = system;
-      writeSystemLog( ">Equipped:" );
-      writeSystemLog( system->getNamePadded() );
+   }
+   else if (equip( system, SYSTEM ) == 0) {
       return 0;
    }
    else
-   { 
-      int count = 1;
-      Item *cur = systems;
-      while( count < num_systems ) {
-         if (cur->next == NULL) { // Slot in here
-            cur->next = system;
-            writeSystemLog( ">Equipped:" );
-            writeSystemLog( system->getNamePadded() );
-            return 0;
-         }
-         cur = cur->next;
-         count++;
-      }
-
+   {
       // No space
-      log("Chassis can't add system, no more system slots");
+      log("Chassis can't add system, no more system slots", LOG_LEVEL_ERROR);
       retval = -1;
    }
 
    writeSystemLog( ">Unable to equip:" );
-   writeSystemLog( system->getNamePadded() );
+   writeSystemLog( system->getName(), 1 );
 
    return retval;
 }
 
 Item* Chassis::removeArm( int number )
 {
-   if ( number < 0 || number >= num_arms ) {
-      log("Chassis can't remove arm, number is invalid");
+   if ( number < 0 || number >= def->num_arms ) {
+      log("Chassis can't remove arm, number is invalid", LOG_LEVEL_ERROR);
       return NULL;
    }
 
-   Item *cur, *to_remove;
-
-   if ( number == 0 ) {
-      to_remove = arms;
-      if (arms != NULL)
-         arms = arms->next;
-      return to_remove;
-   }
-
-   int count = 1;
-   cur = arms;
-   while (cur != NULL) {
-      to_remove = cur->next;
-      if (count == number) {
-         // Remove to_remove
-         if (to_remove != NULL)
-            cur->next = to_remove->next;
-
-         return to_remove;
-      }
-
-      cur = cur->next;
-      count++;
-   }
-   // No arm at this number
-   log("Chassis can't remove arm, no arm at this number");
-   return NULL;
+   return removeAny( firstSlot( ARM ) + number );
 }
 
 Item* Chassis::removeMount( int number )
 {
-   if ( number < 0 || number >= num_mounts ) {
-      log("Chassis can't remove mount, number is invalid");
+   if ( number < 0 || number >= def->num_mounts ) {
+      log("Chassis can't remove mount, number is invalid", LOG_LEVEL_ERROR);
       return NULL;
    }
 
-   Item *cur, *to_remove;
-
-   if ( number == 0 ) {
-      to_remove = mounts;
-      if (mounts != NULL)
-         mounts = mounts->next;
-      return to_remove;
-   }
-
-   int count = 1;
-   cur = mounts;
-   while (cur != NULL) {
-      to_remove = cur->next;
-      if (count == number) {
-         // Remove to_remove
-         if (to_remove != NULL)
-            cur->next = to_remove->next;
-
-         return to_remove;
-      }
-
-      cur = cur->next;
-      count++;
-   }
-   // No mount at this number
-   log("Chassis can't remove mount, no mount at this number");
-   return NULL;
+   return removeAny( firstSlot( MOUNT ) + number );
 }
 
 Item* Chassis::removeSystem( int number )
 {
-   if ( number < 0 || number >= num_systems ) {
-      log("Chassis can't remove system, number is invalid");
+   if ( number < 0 || number >= def->num_systems ) {
+      log("Chassis can't remove system, number is invalid", LOG_LEVEL_ERROR);
       return NULL;
    }
 
-   Item *cur, *to_remove;
-
-   if ( number == 0 ) {
-      to_remove = systems;
-      if (systems != NULL)
-         systems = systems->next;
-      return to_remove;
-   }
-
-   int count = 1;
-   cur = systems;
-   while (cur != NULL) {
-      to_remove = cur->next;
-      if (count == number) {
-         // Remove to_remove
-         if (to_remove != NULL)
-            cur->next = to_remove->next;
-
-         return to_remove;
-      }
-
-      cur = cur->next;
-      count++;
-   }
-   // No system at this number
-   log("Chassis can't remove system, no system at this number");
-   return NULL;
+   return removeAny( firstSlot( SYSTEM ) + number );
 }
 
+// Empties slot 'number', counting arms, then mounts, then systems
 Item* Chassis::removeAny( int number )
 {
    if (number < 0 || number >= getTotalSlots()) {
-      log("Can't removeAny, number is invalid");
+      log("Can't removeAny, number is invalid", LOG_LEVEL_ERROR);
       return NULL;
    }
 
-   if (number < num_arms)
-      return removeArm( number );
-
-   number -= num_arms;
-
-   if (number < num_mounts)
-      return removeMount( number );
-
-   number -= num_mounts;
-
-   return removeSystem( number );
+   Item *to_remove = slots[number];
+   slots[number] = NULL;
+   rebuildIndexes();
+   return to_remove;
 }
 
 void Chassis::findAndRemoveItem( Item *to_remove )
 {
-   Item *all_items = getAllItems();
-   int count = 0;
-
-   while (all_items != NULL) {
-      if (all_items == to_remove)
-         removeAny( count );
+   int total = getTotalSlots();
+   for (int i = 0; i < total; ++i) {
+      if (slots[i] == to_remove)
+         slots[i] = NULL;
+   }
+   rebuildIndexes();
+}
 
-      all_items = all_items->alt_next;
-      count++;
+int Chassis::restoreSlot( int number, Item *item )
+{
+   if (number < 0 || number >= getTotalSlots() || slots[number] != NULL) {
+      log("Can't restoreSlot, number is invalid or the slot is full", LOG_LEVEL_ERROR);
+      return -1;
    }
+
+   slots[number] = item;
+   rebuildIndexes();
+   return 0;
 }
 
 ItemType Chassis::getSlot( int number )
@@ -742,815 +569,236 @@ ItemType Chassis::getSlot( int number )
    if (number < 0 || number >= getTotalSlots())
       return CHASSIS;
 
-   if (number < num_arms)
+   if (number < def->num_arms)
       return ARM;
 
-   number -= num_arms;
+   number -= def->num_arms;
 
-   if (number < num_mounts)
+   if (number < def->num_mounts)
       return MOUNT;
 
-   number -= num_mounts;
-
    return SYSTEM;
 }
 
 int Chassis::getTotalSlots()
 {
-   return num_arms + num_mounts + num_systems;
+   return def->num_arms + def->num_mounts + def->num_systems;
 }
 
 void Chassis::listEquipment( int selection )
 {
    const int column = 31, header_column = 29, column_end = 50;
+   const char *headers[3] = { "ARM SLOTS:", "MOUNT SLOTS:", "SYSTEM SLOTS:" };
+   const ItemType slot_types[3] = { ARM, MOUNT, SYSTEM };
    int row = 1, count = 0;
-   Item *to_write;
-
-   to_write = arms;
-   writeString( "ARM SLOTS:", C_WHITE, C_BLACK, header_column, row );
-   ++row;
-   for (int i = 0; i < num_arms; ++i) {
-      if (to_write != NULL) {
-         writeString( to_write->getName(), C_WHITE, C_BLACK, column, row );
-         to_write = to_write->next;
-      }
-      else {
-         writeString( "<empty>", C_WHITE, C_BLACK, column, row );
-      }
 
-      if (count == selection)
-         colorInvert( column, row, column_end, row );
-   
-      ++count;
+   for (int t = 0; t < 3; ++t) {
+      writeString( headers[t], C_WHITE, C_BLACK, header_column, row );
       ++row;
-   }
 
-   to_write = mounts;
-   writeString( "MOUNT SLOTS:", C_WHITE, C_BLACK, header_column, row );
-   ++row;
-   for (int i = 0; i < num_mounts; ++i) {
-      if (to_write != NULL) {
-         writeString( to_write->getName(), C_WHITE, C_BLACK, column, row );
-         to_write = to_write->next;
-      }
-      else
-         writeString( "<empty>", C_WHITE, C_BLACK, column, row );
+      int num = numSlots( slot_types[t] );
+      for (int i = 0; i < num; ++i) {
+         Item *to_write = slots[count];
+         if (to_write != NULL)
+            writeString( to_write->getName(), C_WHITE, C_BLACK, column, row );
+         else
+            writeString( "<empty>", C_WHITE, C_BLACK, column, row );
 
-      if (count == selection)
-         colorInvert( column, row, column_end, row );
+         if (count == selection)
+            colorInvert( column, row, column_end, row );
 
-      ++count;
-      ++row;
-   }
-      
-   to_write = systems;
-   writeString( "SYSTEM SLOTS:", C_WHITE, C_BLACK, header_column, row );
-   ++row;
-   for (int i = 0; i < num_systems; ++i) {
-      if (to_write != NULL) {
-         writeString( to_write->getName(), C_WHITE, C_BLACK, column, row );
-         to_write = to_write->next;
+         ++count;
+         ++row;
       }
-      else
-         writeString( "<empty>", C_WHITE, C_BLACK, column, row );
-
-      if (count == selection)
-         colorInvert( column, row, column_end, row );
-
-      ++count;
-      ++row;
    }
 }
 
+/* Picks the chassis itself or one of its equipped items.  With
+ * TARGET_CHASSIS the chassis gets three extra chances.
+ */
 Item *Chassis::selectRandomItem( int flags )
 {
-   Item *alt_stack = getAllItems();
-   Item *it = alt_stack;
-
-   int count = 0;
-   while (it != NULL){
-      count++;
-      it = it->alt_next;
-   }
+   ItemSpan all = getAllItems();
 
-   if (flags && TARGET_CHASSIS)
-      count += 3;
+   int chassis_chances = 1;
+   if (flags & TARGET_CHASSIS)
+      chassis_chances += 3;
 
-   int r = rand() % (count + 1);
+   int r = rng( COMBAT_RNG ).below( all.count + chassis_chances );
 
-   if (r == 0) return this;
+   if (r < chassis_chances) return this;
 
-   count = 1;
-   while (count < r) {
-      alt_stack = alt_stack->alt_next;
-      count++;
-   }
-
-   return alt_stack;
+   return all[r - chassis_chances];
 }
 
 void Chassis::drawChassisStats( int row )
 {
-   std::stringstream dur_str;
-   dur_str << "Durability:  " << durability << "/" << max_durability;
-
-   writeString( dur_str.str(), C_WHITE, C_BLACK, 34, row );
+   writeFormatted( C_WHITE, C_BLACK, 34, row, "Durability:  %d/%d", durability, def->max_durability );
 }
 
 Chassis::~Chassis()
 { }
 
-//////////////////////////////////////////////////////////////////////
-// Specific Chassises
-//////////////////////////////////////////////////////////////////////
-
-
-BasicChassis::BasicChassis()
-{
-   initBasics();
-
-   type = CHASSIS;
-
-   display_char = '&';
-   arms = NULL;
-   mounts = NULL;
-   systems = NULL;
-
-   num_arms = 2;
-   num_mounts = 1;
-   num_systems = 3;
-
-   num_actions = 1;
-
-   durability = max_durability = 100;
-   armor = 5;
-   rearm_time = 0;
-}
-
-std::string BasicChassis::getName() {
-   return "Basic Chassis";
-}
-
-void BasicChassis::drawDescription()
-{
-   writeString( getName(), C_WHITE, C_BLACK, desc_col, 2 );
-   writeString( "A typical robotic frame,", C_WHITE, C_BLACK, desc_col, 4);
-   writeString( "with plug-and-play ports", C_WHITE, C_BLACK, desc_col, 5);
-   writeString( "for arms, system mods, and", C_WHITE, C_BLACK, desc_col, 6);
-   writeString( "an extra heavy mount.", C_WHITE, C_BLACK, desc_col, 7);
-
-   drawChassisStats( 9 );
-}
-
-void BasicChassis::drawEquipScreen( int selection )
-{
-   writeString("        Basic Chassis", C_WHITE, C_BLACK, 0, 2);
-   writeString("          ----------", C_WHITE, C_BLACK, 0, 4);
-   writeString("         |          |", C_WHITE, C_BLACK, 0, 5);
-   writeString("         |  /\\  /\\  |", C_WHITE, C_BLACK, 0, 6);
-   writeString("         |  \\/  \\/  |", C_WHITE, C_BLACK, 0, 7);
-   writeString("         |          |", C_WHITE, C_BLACK, 0, 8);
-   writeString("         |    ==    |  ++", C_WHITE, C_BLACK, 0, 9);
-   writeString("          ----------   ++", C_WHITE, C_BLACK, 0, 10);
-   writeString("              ||      //", C_WHITE, C_BLACK, 0, 11);
-   writeString("      ------------------", C_WHITE, C_BLACK, 0, 12);
-   writeString("      /                \\", C_WHITE, C_BLACK, 0, 13);
-   writeString("     /  / \\        / \\  \\", C_WHITE, C_BLACK, 0, 14);
-   writeString("    /  /   \\      /   \\  \\", C_WHITE, C_BLACK, 0, 15);
-   writeString("    | |     \\    /     | |", C_WHITE, C_BLACK, 0, 16);
-   writeString("    | |      \\--/      | |", C_WHITE, C_BLACK, 0, 17);
-   writeString("    +++       ||       +++", C_WHITE, C_BLACK, 0, 18);
-   writeString("            ------", C_WHITE, C_BLACK, 0, 19);
-   writeString("           |      |", C_WHITE, C_BLACK, 0, 20);
-   writeString("          / ------ \\", C_WHITE, C_BLACK, 0, 21);
-   writeString("         //        \\\\", C_WHITE, C_BLACK, 0, 22);
-   writeString("         ||        ||", C_WHITE, C_BLACK, 0, 23);
-   writeString("         ||        ||", C_WHITE, C_BLACK, 0, 24);
-   writeString("         ||        ||", C_WHITE, C_BLACK, 0, 25);
-   writeString("       ----        ----", C_WHITE, C_BLACK, 0, 26);
-
-   listEquipment( selection );
-}
-
-BasicChassis::~BasicChassis() { }
-
-QuadChassis::QuadChassis()
-{
-   initBasics();
-
-   type = CHASSIS;
-
-   display_char = '&';
-   arms = NULL;
-   mounts = NULL;
-   systems = NULL;
-
-   num_arms = 4;
-   num_mounts = 1;
-   num_systems = 3;
-
-   num_actions = 1;
-
-   durability = max_durability = 120;
-   armor = 5;
-   rearm_time = 0;
-}
-
-std::string QuadChassis::getName() {
-   return "Quad Chassis";
-}
-
-void QuadChassis::drawDescription()
-{
-   writeString( getName(), C_WHITE, C_BLACK, desc_col, 2 );
-   writeString( "A four-armed extension of", C_WHITE, C_BLACK, desc_col, 4);
-   writeString( "the basic frame, built for", C_WHITE, C_BLACK, desc_col, 5);
-   writeString( "mining and melee combat.", C_WHITE, C_BLACK, desc_col, 6);
-
-   drawChassisStats( 8 );
-}
-
-void QuadChassis::drawEquipScreen( int selection )
-{
-   writeString("                              ", C_WHITE, C_BLACK, 0, 2);
-   writeString("                              ", C_WHITE, C_BLACK, 0, 3);
-   writeString("                              ", C_WHITE, C_BLACK, 0, 4);
-   writeString("                              ", C_WHITE, C_BLACK, 0, 5);
-   writeString("                              ", C_WHITE, C_BLACK, 0, 6);
-   writeString("                              ", C_WHITE, C_BLACK, 0, 7);
-   writeString("                              ", C_WHITE, C_BLACK, 0, 8);
-   writeString("                              ", C_WHITE, C_BLACK, 0, 9);
-   writeString("                              ", C_WHITE, C_BLACK, 0, 10);
-   writeString("                              ", C_WHITE, C_BLACK, 0, 11);
-   writeString("                              ", C_WHITE, C_BLACK, 0, 12);
-   writeString("                              ", C_WHITE, C_BLACK, 0, 13);
-   writeString("                              ", C_WHITE, C_BLACK, 0, 14);
-   writeString("                              ", C_WHITE, C_BLACK, 0, 15);
-   writeString("                              ", C_WHITE, C_BLACK, 0, 16);
-   writeString("                              ", C_WHITE, C_BLACK, 0, 17);
-   writeString("                              ", C_WHITE, C_BLACK, 0, 18);
-   writeString("                              ", C_WHITE, C_BLACK, 0, 19);
-   writeString("                              ", C_WHITE, C_BLACK, 0, 20);
-   writeString("                              ", C_WHITE, C_BLACK, 0, 21);
-   writeString("                              ", C_WHITE, C_BLACK, 0, 22);
-   writeString("                              ", C_WHITE, C_BLACK, 0, 23);
-   writeString("                              ", C_WHITE, C_BLACK, 0, 24);
-   writeString("                              ", C_WHITE, C_BLACK, 0, 25);
-   writeString("                              ", C_WHITE, C_BLACK, 0, 26);
-   writeString("                              ", C_WHITE, C_BLACK, 0, 27);
-
-   listEquipment( selection );
-
-}
-
-QuadChassis::~QuadChassis() { }
-
-DomeChassis::DomeChassis()
-{
-   initBasics();
-
-   type = CHASSIS;
-
-   display_char = '&';
-   arms = NULL;
-   mounts = NULL;
-   systems = NULL;
-
-   num_arms = 2;
-   num_mounts = 2;
-   num_systems = 6;
-
-   num_actions = 1;
-
-   durability = max_durability = 300;
-   armor = 5;
-   rearm_time = 0;
-}
-
-std::string DomeChassis::getName() {
-   return "Dome Chassis";
-}
-
-void DomeChassis::drawDescription()
-{
-   writeString( getName(), C_WHITE, C_BLACK, desc_col, 2 );
-   writeString( "A rolling frame designed for", C_WHITE, C_BLACK, desc_col, 4);
-   writeString( "calculation and command.", C_WHITE, C_BLACK, desc_col, 5);
-   writeString( "Tough and efficient.", C_WHITE, C_BLACK, desc_col, 6);
-
-   drawChassisStats( 8 );
-} 
-
-void DomeChassis::drawEquipScreen( int selection )
-{
-   writeString("                              ", C_WHITE, C_BLACK, 0, 2);
-   writeString("                              ", C_WHITE, C_BLACK, 0, 3);
-   writeString("                              ", C_WHITE, C_BLACK, 0, 4);
-   writeString("                              ", C_WHITE, C_BLACK, 0, 5);
-   writeString("                              ", C_WHITE, C_BLACK, 0, 6);
-   writeString("                              ", C_WHITE, C_BLACK, 0, 7);
-   writeString("                              ", C_WHITE, C_BLACK, 0, 8);
-   writeString("                              ", C_WHITE, C_BLACK, 0, 9);
-   writeString("                              ", C_WHITE, C_BLACK, 0, 10);
-   writeString("                              ", C_WHITE, C_BLACK, 0, 11);
-   writeString("                              ", C_WHITE, C_BLACK, 0, 12);
-   writeString("                              ", C_WHITE, C_BLACK, 0, 13);
-   writeString("                              ", C_WHITE, C_BLACK, 0, 14);
-   writeString("                              ", C_WHITE, C_BLACK, 0, 15);
-   writeString("                              ", C_WHITE, C_BLACK, 0, 16);
-   writeString("                              ", C_WHITE, C_BLACK, 0, 17);
-   writeString("                              ", C_WHITE, C_BLACK, 0, 18);
-   writeString("                              ", C_WHITE, C_BLACK, 0, 19);
-   writeString("                              ", C_WHITE, C_BLACK, 0, 20);
-   writeString("                              ", C_WHITE, C_BLACK, 0, 21);
-   writeString("                              ", C_WHITE, C_BLACK, 0, 22);
-   writeString("                              ", C_WHITE, C_BLACK, 0, 23);
-   writeString("                              ", C_WHITE, C_BLACK, 0, 24);
-   writeString("                              ", C_WHITE, C_BLACK, 0, 25);
-   writeString("                              ", C_WHITE, C_BLACK, 0, 26);
-   writeString("                              ", C_WHITE, C_BLACK, 0, 27);
-
-   listEquipment( selection );
-
-}
-
-DomeChassis::~DomeChassis() { }
-
-CritterChassis::CritterChassis()
-{
-   initBasics();
-
-   type = CHASSIS;
-
-   display_char = '&';
-   arms = NULL;
-   mounts = NULL;
-   systems = NULL;
-
-   num_arms = 0;
-   num_mounts = 2;
-   num_systems = 3;
-
-   num_actions = 1;
-
-   durability = max_durability = 180;
-   armor = 5;
-   rearm_time = 0;
-}
-
-std::string CritterChassis::getName() {
-   return "Critter Chassis";
-}
-
-void CritterChassis::drawDescription()
-{
-   writeString( getName(), C_WHITE, C_BLACK, desc_col, 2 );
-   writeString( "A compact frame specializing", C_WHITE, C_BLACK, desc_col, 4);
-   writeString( "in staying out of the way.", C_WHITE, C_BLACK, desc_col, 5);
-
-   drawChassisStats( 7 );
-} 
-
-void CritterChassis::drawEquipScreen( int selection )
-{
-   writeString("                              ", C_WHITE, C_BLACK, 0, 2);
-   writeString("                              ", C_WHITE, C_BLACK, 0, 3);
-   writeString("                              ", C_WHITE, C_BLACK, 0, 4);
-   writeString("                              ", C_WHITE, C_BLACK, 0, 5);
-   writeString("                              ", C_WHITE, C_BLACK, 0, 6);
-   writeString("                              ", C_WHITE, C_BLACK, 0, 7);
-   writeString("                              ", C_WHITE, C_BLACK, 0, 8);
-   writeString("                              ", C_WHITE, C_BLACK, 0, 9);
-   writeString("                              ", C_WHITE, C_BLACK, 0, 10);
-   writeString("                              ", C_WHITE, C_BLACK, 0, 11);
-   writeString("                              ", C_WHITE, C_BLACK, 0, 12);
-   writeString("                              ", C_WHITE, C_BLACK, 0, 13);
-   writeString("                              ", C_WHITE, C_BLACK, 0, 14);
-   writeString("                              ", C_WHITE, C_BLACK, 0, 15);
-   writeString("                              ", C_WHITE, C_BLACK, 0, 16);
-   writeString("                              ", C_WHITE, C_BLACK, 0, 17);
-   writeString("                              ", C_WHITE, C_BLACK, 0, 18);
-   writeString("                              ", C_WHITE, C_BLACK, 0, 19);
-   writeString("                              ", C_WHITE, C_BLACK, 0, 20);
-   writeString("                              ", C_WHITE, C_BLACK, 0, 21);
-   writeString("                              ", C_WHITE, C_BLACK, 0, 22);
-   writeString("                              ", C_WHITE, C_BLACK, 0, 23);
-   writeString("                              ", C_WHITE, C_BLACK, 0, 24);
-   writeString("                              ", C_WHITE, C_BLACK, 0, 25);
-   writeString("                              ", C_WHITE, C_BLACK, 0, 26);
-   writeString("                              ", C_WHITE, C_BLACK, 0, 27);
-
-   listEquipment( selection );
-
-}
-
-CritterChassis::~CritterChassis() { }
-
-HeavyChassis::HeavyChassis()
-{
-   initBasics();
-
-   type = CHASSIS;
-
-   display_char = '&';
-   arms = NULL;
-
-   num_arms = 4;
-   num_mounts = 6;
-   num_systems = 4;
-
-   num_actions = 1;
-
-   durability = max_durability = 700;
-   armor = 5;
-}
-
-std::string HeavyChassis::getName() {
-   return "Heavy Chassis";
-}
-
-void HeavyChassis::drawDescription()
-{
-   writeString( getName(), C_WHITE, C_BLACK, desc_col, 2 );
-   writeString( "A massive bipedal frame with", C_WHITE, C_BLACK, desc_col, 4);
-   writeString( "multiple heavy launchers.", C_WHITE, C_BLACK, desc_col, 5);
-   writeString( "Very powerful, but slow.", C_WHITE, C_BLACK, desc_col, 6);
-
-   drawChassisStats( 9 );
-}
-
-void HeavyChassis::drawEquipScreen( int selection )
-{
-   writeString("                              ", C_WHITE, C_BLACK, 0, 2);
-   writeString("                              ", C_WHITE, C_BLACK, 0, 3);
-   writeString("                              ", C_WHITE, C_BLACK, 0, 4);
-   writeString("                              ", C_WHITE, C_BLACK, 0, 5);
-   writeString("                              ", C_WHITE, C_BLACK, 0, 6);
-   writeString("                              ", C_WHITE, C_BLACK, 0, 7);
-   writeString("                              ", C_WHITE, C_BLACK, 0, 8);
-   writeString("                              ", C_WHITE, C_BLACK, 0, 9);
-   writeString("                              ", C_WHITE, C_BLACK, 0, 10);
-   writeString("                              ", C_WHITE, C_BLACK, 0, 11);
-   writeString("                              ", C_WHITE, C_BLACK, 0, 12);
-   writeString("                              ", C_WHITE, C_BLACK, 0, 13);
-   writeString("                              ", C_WHITE, C_BLACK, 0, 14);
-   writeString("                              ", C_WHITE, C_BLACK, 0, 15);
-   writeString("                              ", C_WHITE, C_BLACK, 0, 16);
-   writeString("                              ", C_WHITE, C_BLACK, 0, 17);
-   writeString("                              ", C_WHITE, C_BLACK, 0, 18);
-   writeString("                              ", C_WHITE, C_BLACK, 0, 19);
-   writeString("                              ", C_WHITE, C_BLACK, 0, 20);
-   writeString("                              ", C_WHITE, C_BLACK, 0, 21);
-   writeString("                              ", C_WHITE, C_BLACK, 0, 22);
-   writeString("                              ", C_WHITE, C_BLACK, 0, 23);
-   writeString("                              ", C_WHITE, C_BLACK, 0, 24);
-   writeString("                              ", C_WHITE, C_BLACK, 0, 25);
-   writeString("                              ", C_WHITE, C_BLACK, 0, 26);
-   writeString("                              ", C_WHITE, C_BLACK, 0, 27);
-
-   listEquipment( selection );
-
-}
-
-HeavyChassis::~HeavyChassis() { }
-
-OrbChassis::OrbChassis()
-{
-   initBasics();
-
-   type = CHASSIS;
-   weapon_type = NOT_A_WEAPON;
-
-   display_char = '&';
-   arms = NULL;
-   mounts = NULL;
-   systems = NULL;
-
-   num_arms = 6;
-   num_mounts = 0;
-   num_systems = 7;
-
-   num_actions = 1;
-
-   durability = max_durability = 420;
-   armor = 5;
-   rearm_time = 0;
-}
-
-std::string OrbChassis::getName() {
-   return "Orb Chassis";
-}
-
-void OrbChassis::drawDescription()
-{
-   writeString( getName(), C_WHITE, C_BLACK, desc_col, 2 );
-   writeString( "A levitating orb with six", C_WHITE, C_BLACK, desc_col, 4);
-   writeString( "heavy-duty arm sockets.", C_WHITE, C_BLACK, desc_col, 5);
-   writeString( "Extremely mobile, but", C_WHITE, C_BLACK, desc_col, 6);
-   writeString( "with high energy costs.", C_WHITE, C_BLACK, desc_col, 7);
-
-   drawChassisStats( 9 );
-}
-
-void OrbChassis::drawEquipScreen( int selection )
-{
-   writeString("         Orb Chassis          ", C_WHITE, C_BLACK, 0, 2);
-   writeString("                              ", C_WHITE, C_BLACK, 0, 3);
-   writeString("                              ", C_WHITE, C_BLACK, 0, 4);
-   writeString("                              ", C_WHITE, C_BLACK, 0, 5);
-   writeString("                              ", C_WHITE, C_BLACK, 0, 6);
-   writeString("       +++         +++        ", C_WHITE, C_BLACK, 0, 7);
-   writeString("       \\  \\       /  /        ", C_WHITE, C_BLACK, 0, 8);
-   writeString("        \\  \\     /  /         ", C_WHITE, C_BLACK, 0, 9);
-   writeString("         \\  \\---/  /          ", C_WHITE, C_BLACK, 0, 10);
-   writeString("          \\/     \\/           ", C_WHITE, C_BLACK, 0, 11);
-   writeString("     +----|       |----+      ", C_WHITE, C_BLACK, 0, 12);
-   writeString("     +    |  (O)  |    +      ", C_WHITE, C_BLACK, 0, 13);
-   writeString("     +----|       |----+      ", C_WHITE, C_BLACK, 0, 14);
-   writeString("          /\\     /\\           ", C_WHITE, C_BLACK, 0, 15);
-   writeString("         /  /---\\  \\          ", C_WHITE, C_BLACK, 0, 16);
-   writeString("        /  /     \\  \\         ", C_WHITE, C_BLACK, 0, 17);
-   writeString("       /  /       \\  \\        ", C_WHITE, C_BLACK, 0, 18);
-   writeString("       +++         +++        ", C_WHITE, C_BLACK, 0, 19);
-   writeString("                              ", C_WHITE, C_BLACK, 0, 20);
-   writeString("                              ", C_WHITE, C_BLACK, 0, 21);
-   writeString("                              ", C_WHITE, C_BLACK, 0, 22);
-   writeString("                              ", C_WHITE, C_BLACK, 0, 23);
-   writeString("                              ", C_WHITE, C_BLACK, 0, 24);
-   writeString("                              ", C_WHITE, C_BLACK, 0, 25);
-   writeString("                              ", C_WHITE, C_BLACK, 0, 26);
-   writeString("                              ", C_WHITE, C_BLACK, 0, 27);
-
-   listEquipment( selection );
-}
-
-OrbChassis::~OrbChassis() { }
 
 //////////////////////////////////////////////////////////////////////
-// Arms
+// Special Items
 //////////////////////////////////////////////////////////////////////
 
-int Arm::drawActions()
-{
-   int row = actions_start_row;
-
-   writeString( "Actions:", C_WHITE, C_BLACK, actions_header_column, row );
-   row++;
-
-   writeString( "a)", C_GRAY, C_BLACK, actions_header_column, row);
-   writeString( "Drop", C_WHITE, C_BLACK, actions_column, row );
-   row++;
-   writeString( "b)", C_GRAY, C_BLACK, actions_header_column, row);
-   writeString( "Equip (Arm)", C_WHITE, C_BLACK, actions_column, row );
-
-   return num_actions;
-}
-
+Laser::Laser() : Item( LASER )
+{ }
 
-int Arm::doAction( int selection )
+int Laser::rangedAttack( Unit *attacker, Unit *target )
 {
-   if (selection == 0)
-      dropItem( this );
-   else if (selection == 1) {
-      Chassis* ch = player->chassis;
-      if (ch) {
-         if (ch->addArm( this ) != 0)
-            return -1;
-      }
-   }
-   else
-      return -1;
-
+   writeSystemLog( ">PEW PEW" );
    return 0;
 }
 
-Arm::~Arm() { }
-
-ClawArm::ClawArm()
-{
-   initBasics();
-
-   type = ARM;
-   weapon_type = MELEE_WEAPON;
-
-   num_actions = 2;
-
-   display_char = '(';
-
-   durability = max_durability = 120;
-   armor = 5;
-   rearm_time = 0;
-}
-
-int ClawArm::meleeAttack( Unit *target )
-{
-   return genericMeleeAttack( target, 30, 10 );
-}
-
-std::string ClawArm::getName()
-{
-   return "VRX110 Manipulator";
-} 
-
-void ClawArm::drawDescription()
-{
-   writeString( getName(), C_WHITE, C_BLACK, desc_col, 2 );
-   writeString( "A mechanical arm that ends", C_WHITE, C_BLACK, desc_col, 4);
-   writeString( "in a gripping claw.", C_WHITE, C_BLACK, desc_col, 5);
-}
-
-ClawArm::~ClawArm() { }
-
-HammerArm::HammerArm()
-{
-   initBasics();
-
-   type = ARM;
-   weapon_type = MELEE_WEAPON;
-
-   num_actions = 2;
-
-   display_char = '(';
-
-   durability = max_durability = 200;
-   armor = 5;
-   rearm_time = 0;
-}
-
-int HammerArm::meleeAttack( Unit *target )
-{
-   return genericMeleeAttack( target, 50, 10 );
-}
-
-std::string HammerArm::getName()
-{
-   return "Series A7 Demolisher";
-} 
-
-void HammerArm::drawDescription()
-{
-   writeString( getName(), C_WHITE, C_BLACK, desc_col, 2 );
-   writeString( "A massive pneumatic hammer.", C_WHITE, C_BLACK, desc_col, 4);
-}
-
-HammerArm::~HammerArm() { }
-
-ShockArm::ShockArm()
-{
-   initBasics();
-
-   type = ARM;
-   weapon_type = MELEE_WEAPON;
-
-   num_actions = 2;
-
-   display_char = '(';
-
-   durability = max_durability = 100;
-   armor = 5;
-   rearm_time = 0;
-}
-
-int ShockArm::meleeAttack( Unit *target )
-{
-   return genericMeleeAttack( target, 30, 15, MELEE_DISABLING );
-}
-
-std::string ShockArm::getName()
-{
-   return "VRX770 Heavy Taser";
-} 
-
-void ShockArm::drawDescription()
-{
-   writeString( getName(), C_WHITE, C_BLACK, desc_col, 2 );
-   writeString( "Delivers 42,000,000V", C_WHITE, C_BLACK, desc_col, 4);
-   writeString( "directly into the target.", C_WHITE, C_BLACK, desc_col, 5);
-}
-
-ShockArm::~ShockArm() { }
-
-EnergyLance::EnergyLance()
-{
-   initBasics();
-
-   type = ARM;
-   weapon_type = MELEE_WEAPON;
-
-   num_actions = 2;
-
-   display_char = '(';
-
-   durability = max_durability = 50;
-   armor = 5;
-
-   rearm_time = 0;
-}
-
-int EnergyLance::meleeAttack( Unit *target )
-{
-   return genericMeleeAttack( target, 40, 40, MELEE_PIERCING );
-}
-
-std::string EnergyLance::getName()
-{
-   return "Energy Lance Mk 1";
-} 
-
-void EnergyLance::drawDescription()
-{
-   writeString( getName(), C_WHITE, C_BLACK, desc_col, 2 );
-   writeString( "Spears your target on a", C_WHITE, C_BLACK, desc_col, 4);
-   writeString( "cone of destructive energy.", C_WHITE, C_BLACK, desc_col, 5);
-}
-
-EnergyLance::~EnergyLance() { }
+Laser::~Laser() { }
 
 //////////////////////////////////////////////////////////////////////
-// Mounts
+// Item Definitions
 //////////////////////////////////////////////////////////////////////
 
-int Mount::drawActions()
-{
-   int row = actions_start_row;
-
-   writeString( "Actions:", C_WHITE, C_BLACK, actions_header_column, row );
-   row++;
-
-   writeString( "a)", C_GRAY, C_BLACK, actions_header_column, row);
-   writeString( "Drop", C_WHITE, C_BLACK, actions_column, row );
-   row++;
-   writeString( "b)", C_GRAY, C_BLACK, actions_header_column, row);
-   writeString( "Equip (Mount)", C_WHITE, C_BLACK, actions_column, row );
-   row++;
-   writeString( "c)", C_GRAY, C_BLACK, actions_header_column, row);
-   writeString( "Equip (Arm)", C_WHITE, C_BLACK, actions_column, row );
-
-   return num_actions;
-}
-
-
-int Mount::doAction( int selection )
-{
-   if (selection == 0)
-      dropItem( this );
-   else if (selection == 1) {
-      Chassis* ch = player->chassis;
-      if (ch) {
-         if (ch->addMount( this ) != 0)
-            return -1;
-      }
-   }
-   else if (selection == 2) {
-      Chassis* ch = player->chassis;
-      if (ch) {
-         if (ch->addArm( this ) != 0)
-            return -1;
-      }
-   }
-   else
-      return -1;
-
-   return 0;
-}
-
-Mount::~Mount() { }
-
-Laser::Laser()
-{
-   initBasics();
-
-   type = MOUNT;
-   weapon_type = RANGED_WEAPON;
-
-   num_actions = 3;
-
-   display_char = '}';
-
-   durability = max_durability = 60;
-   armor = 5;
-
-   rearm_time = 0;
-   targetted = true;
-}
-
-int Laser::rangedAttack( Unit *target )
-{
-   writeSystemLog( ">PEW PEW" );
-   return 0;
-}
-
-std::string Laser::getName()
-{
-   return "VRX24 Mining Laser";
-} 
-
-void Laser::drawDescription()
-{
-   writeString( getName(), C_WHITE, C_BLACK, desc_col, 2 );
-   writeString( "Fires a beam of concentrated", C_WHITE, C_BLACK, desc_col, 4);
-   writeString( "photons that can eat", C_WHITE, C_BLACK, desc_col, 5);
-   writeString( "through any material.", C_WHITE, C_BLACK, desc_col, 6);
-}
-
-Laser::~Laser() { }
+static const char *basic_chassis_art[] = {
+   "        Basic Chassis",
+   "",
+   "          ----------",
+   "         |          |",
+   "         |  /\\  /\\  |",
+   "         |  \\/  \\/  |",
+   "         |          |",
+   "         |    ==    |  ++",
+   "          ----------   ++",
+   "              ||      //",
+   "      ------------------",
+   "      /                \\",
+   "     /  / \\        / \\  \\",
+   "    /  /   \\      /   \\  \\",
+   "    | |     \\    /     | |",
+   "    | |      \\--/      | |",
+   "    +++       ||       +++",
+   "            ------",
+   "           |      |",
+   "          / ------ \\",
+   "         //        \\\\",
+   "         ||        ||",
+   "         ||        ||",
+   "         ||        ||",
+   "       ----        ----",
+   NULL
+};
+
+static const char *orb_chassis_art[] = {
+   "         Orb Chassis          ",
+   "",
+   "",
+   "",
+   "",
+   "       +++         +++        ",
+   "       \\  \\       /  /        ",
+   "        \\  \\     /  /         ",
+   "         \\  \\---/  /          ",
+   "          \\/     \\/           ",
+   "     +----|       |----+      ",
+   "     +    |  (O)  |    +      ",
+   "     +----|       |----+      ",
+   "          /\\     /\\           ",
+   "         /  /---\\  \\          ",
+   "        /  /     \\  \\         ",
+   "       /  /       \\  \\        ",
+   "       +++         +++        ",
+   NULL
+};
+
+// Indexed by ItemKind - keep in the same order as the enum
+const ItemDef item_defs[NUM_ITEM_KINDS] = {
+   // kind, name, type, weapon_type, display_char,
+   // max_durability, armor, num_actions, targetted,
+   // dmg_base, dmg_variation, attack_flags,
+   // num_arms, num_mounts, num_systems, equip_art,
+   // description
+
+   { BASIC_CHASSIS, "Basic Chassis", CHASSIS, NOT_A_WEAPON, '&',
+     100, 5, 1, false,
+     0, 0, 0,
+     2, 1, 3, basic_chassis_art,
+     { "A typical robotic frame,",
+       "with plug-and-play ports",
+       "for arms, system mods, and",
+       "an extra heavy mount.", NULL } },
+
+   { QUAD_CHASSIS, "Quad Chassis", CHASSIS, NOT_A_WEAPON, '&',
+     120, 5, 1, false,
+     0, 0, 0,
+     4, 1, 3, NULL,
+     { "A four-armed extension of",
+       "the basic frame, built for",
+       "mining and melee combat.", NULL } },
+
+   { DOME_CHASSIS, "Dome Chassis", CHASSIS, NOT_A_WEAPON, '&',
+     300, 5, 1, false,
+     0, 0, 0,
+     2, 2, 6, NULL,
+     { "A rolling frame designed for",
+       "calculation and command.",
+       "Tough and efficient.", NULL } },
+
+   { CRITTER_CHASSIS, "Critter Chassis", CHASSIS, NOT_A_WEAPON, '&',
+     180, 5, 1, false,
+     0, 0, 0,
+     0, 2, 3, NULL,
+     { "A compact frame specializing",
+       "in staying out of the way.", NULL } },
+
+   { HEAVY_CHASSIS, "Heavy Chassis", CHASSIS, NOT_A_WEAPON, '&',
+     700, 5, 1, false,
+     0, 0, 0,
+     4, 6, 4, NULL,
+     { "A massive bipedal frame with",
+       "multiple heavy launchers.",
+       "Very powerful, but slow.", NULL } },
+
+   { ORB_CHASSIS, "Orb Chassis", CHASSIS, NOT_A_WEAPON, '&',
+     420, 5, 1, false,
+     0, 0, 0,
+     6, 0, 7, orb_chassis_art,
+     { "A levitating orb with six",
+       "heavy-duty arm sockets.",
+       "Extremely mobile, but",
+       "with high energy costs.", NULL } },
+
+   { CLAW_ARM, "VRX110 Manipulator", ARM, MELEE_WEAPON, '(',
+     120, 5, 2, false,
+     30, 10, 0,
+     0, 0, 0, NULL,
+     { "A mechanical arm that ends",
+       "in a gripping claw.", NULL } },
+
+   { HAMMER_ARM, "Series A7 Demolisher", ARM, MELEE_WEAPON, '(',
+     200, 5, 2, false,
+     50, 10, 0,
+     0, 0, 0, NULL,
+     { "A massive pneumatic hammer.", NULL } },
+
+   { SHOCK_ARM, "VRX770 Heavy Taser", ARM, MELEE_WEAPON, '(',
+     100, 5, 2, false,
+     30, 15, MELEE_DISABLING,
+     0, 0, 0, NULL,
+     { "Delivers 42,000,000V",
+       "directly into the target.", NULL } },
+
+   { ENERGY_LANCE, "Energy Lance Mk 1", ARM, MELEE_WEAPON, '(',
+     50, 5, 2, false,
+     40, 40, MELEE_PIERCING,
+     0, 0, 0, NULL,
+     { "Spears your target on a",
+       "cone of destructive energy.", NULL } },
+
+   { LASER, "VRX24 Mining Laser", MOUNT, RANGED_WEAPON, '}',
+     60, 5, 3, true,
+     0, 0, 0,
+     0, 0, 0, NULL,
+     { "Fires a beam of concentrated",
+       "photons that can eat",
+       "through any material.", NULL } }
+};
@@ -2,6 +2,10 @@
 #define ITEMS_H__
 
 #include <string>
+#include <cstddef>
+#include <vector>
+
+#include "handle.h"
 
 struct Unit;
 
@@ -18,7 +22,9 @@ enum ItemType {
    TURRET,
    DEVICE,
    CODE,
-   REMAINS
+   REMAINS,
+
+   NUM_ITEM_TYPES
 };
 
 enum WeaponType {
@@ -26,7 +32,9 @@ enum WeaponType {
    RANGED_WEAPON,
    TACTICAL_WEAPON,
    USABLE_WEAPON,
-   NOT_A_WEAPON
+   NOT_A_WEAPON,
+
+   NUM_WEAPON_TYPES
 };
 
 // Flag values
@@ -40,68 +48,160 @@ enum WeaponType {
 
 #define TARGET_CHASSIS 0x1
 
-struct Item {
+/* Item definitions
+ *
+ * Everything fixed about a kind of item - name, stats, description, how hard
+ * it hits - lives in a shared ItemDef in item_defs[] (see items.cpp).  An Item
+ * only carries the state that changes in play, plus a pointer to its def.
+ * A new item is a new ItemKind and a new row in the table; subclasses are
+ * only for items with unusual behaviour, like Laser.
+ */
+
+enum ItemKind {
+   // Chasses
+   BASIC_CHASSIS, // 2 arm
+   QUAD_CHASSIS, // 4 arm
+   DOME_CHASSIS, // 2 arm rolly thing - e.g. Dalek
+   CRITTER_CHASSIS, // 0 arms - small and fast e.g. mouse bot
+   HEAVY_CHASSIS, // 4 arm many mounts - large and slow
+   ORB_CHASSIS, // 6 arms - levitating mount platform
+   // Arms
+   CLAW_ARM,
+   HAMMER_ARM,
+   SHOCK_ARM,
+   ENERGY_LANCE,
+   // Mounts
+   LASER,
+
+   NUM_ITEM_KINDS
+};
+
+#define MAX_DESCRIPTION_LINES 4
+
+struct ItemDef {
+   ItemKind kind;
+   const char *name;
    ItemType type;
    WeaponType weapon_type;
    unsigned int display_char;
 
-   int durability, max_durability;
+   int max_durability;
    int armor;
-   int rearm_time;
+   int num_actions;
    bool targetted;
+
+   // Used by the default meleeAttack/rangedAttack
+   int dmg_base, dmg_variation, attack_flags;
+
+   // Chassis only
+   int num_arms, num_mounts, num_systems;
+   const char **equip_art; // NULL-terminated, drawn from row 2
+
+   const char *description[MAX_DESCRIPTION_LINES + 1]; // NULL-terminated
+};
+
+extern const ItemDef item_defs[NUM_ITEM_KINDS];
+
+struct Item {
+   Handle handle;
+   const ItemDef *def;
+
+   int durability;
+   int rearm_time;
    
-   Item *next, *alt_next;
+   Item *next;
+   int inv_index; // Position in the carrying Inventory, -1 if not carried
+   int count; // Identical items this one stands for, see Inventory
 
-   void initBasics();
+   Item( ItemKind kind );
 
    void drawItem( int x, int y );
 
-   virtual std::string getName() = 0;
-   std::string getNamePadded( int num=1, char pad=' ' );
+   const char* getName() { return def->name; } // Static storage, never freed
 
    virtual void drawDescription();
 
-   int num_actions;
    virtual int drawActions();
    virtual int doAction( int selection );
 
-   virtual int meleeAttack( Unit *target );
-   int genericMeleeAttack( Unit *target, int base_dmg, int dmg_variation, int flags=0 );
+   // Attacks are reported as CombatEvents - see combat.h
+   virtual int meleeAttack( Unit *attacker, Unit *target );
+   int genericMeleeAttack( Unit *attacker, Unit *target, int base_dmg, int dmg_variation, int flags=0 );
 
-   virtual int rangedAttack( Unit *target );
-   int genericRangedAttack( Unit *target, int base_dmg, int dmg_variation, int flags );
+   virtual int rangedAttack( Unit *attacker, Unit *target );
+   int genericRangedAttack( Unit *attacker, Unit *target, int base_dmg, int dmg_variation, int flags );
+
+   // Items live in itemPool() - see pool.h
+   static void* operator new( size_t size );
+   static void operator delete( void *p );
 
    virtual ~Item();
 };
 
+// Builds the right kind of Item (or Chassis, or special subclass) for a def
+Item* createItem( ItemKind kind );
+
+// A read-only view of a run of Item pointers, e.g. the weapons on a chassis.
+// If 'picks' is set, entry n is items[picks[n]] rather than items[n].
+struct ItemSpan
+{
+   Item **items;
+   const unsigned char *picks;
+   int count;
+
+   ItemSpan() { items = NULL; picks = NULL; count = 0; }
+   ItemSpan( Item **i, int c ) { items = i; picks = NULL; count = c; }
+   ItemSpan( Item **i, const unsigned char *p, int c ) { items = i; picks = p; count = c; }
+
+   Item* operator[]( int n ) const { return picks ? items[picks[n]] : items[n]; }
+   bool empty() const { return count == 0; }
+
+   void appendTo( std::vector<Item*> &out ) const {
+      for (int n = 0; n < count; ++n)
+         out.push_back( (*this)[n] );
+   }
+};
+
 // Chasses
 
-enum ChassisType {
-   BASIC, // 2 arm
-   QUAD, // 4 arm
-   DOME, // 2 arm rolly thing - e.g. Dalek
-   CRITTER, // 0 arms - small and fast e.g. mouse bot
-   HEAVY, // 4 arm many mounts - large and slow
-   ORB // 2 arms - levitating mount platform
+#define MAX_CHASSIS_SLOTS 16
+
+enum EquipIndex {
+   ALL_EQUIPMENT,
+   MELEE_EQUIPMENT,
+   RANGED_EQUIPMENT,
+   TACTICAL_EQUIPMENT,
+   NON_WEAPON_EQUIPMENT,
+
+   NUM_EQUIP_INDEXES
 };
 
+/* Equipment sits in one fixed array of slots: arms first, then mounts, then
+ * systems, with the counts taken from the def.  An empty slot is NULL.
+ *
+ * Alongside the slots the chassis keeps a packed index per EquipIndex: the
+ * numbers of the slots that belong in it, in slot order, one byte each.
+ * Only equipping and removing items rebuilds them, so the getAll*
+ * functions just hand back a span over the ready-made array.  A span is
+ * invalidated by the next change to the chassis.
+ */
 struct Chassis : public Item
 {
-   int num_arms, num_mounts, num_systems;
-   Item *arms, *mounts, *systems;
+   Item *slots[MAX_CHASSIS_SLOTS];
 
-   ChassisType c_type;
+   Chassis( ItemKind kind );
 
-   virtual std::string getName() = 0;
-   virtual void drawEquipScreen( int selection ) = 0;
+   void drawEquipScreen( int selection );
+   virtual void drawDescription();
 
-   Item* removeAll();
+   // Empties every slot, copying what was there into buffer
+   ItemSpan removeAll( Item **buffer );
 
-   Item* getAllItems();
-   Item* getAllMelee();
-   Item* getAllRanged();
-   Item* getAllTactical();
-   Item* getAllNonWeapon();
+   ItemSpan getAllItems() { return getIndex( ALL_EQUIPMENT ); }
+   ItemSpan getAllMelee() { return getIndex( MELEE_EQUIPMENT ); }
+   ItemSpan getAllRanged() { return getIndex( RANGED_EQUIPMENT ); }
+   ItemSpan getAllTactical() { return getIndex( TACTICAL_EQUIPMENT ); }
+   ItemSpan getAllNonWeapon() { return getIndex( NON_WEAPON_EQUIPMENT ); }
 
    int addArm( Item* arm );
    int addMount( Item* mount );
@@ -112,6 +212,8 @@ struct Chassis : public Item
    Item* removeAny( int number );
 
    void findAndRemoveItem( Item *to_remove );
+   // Puts item straight into slot 'number', for loading saved games
+   int restoreSlot( int number, Item *item );
 
    ItemType getSlot( int number );
 
@@ -123,145 +225,26 @@ struct Chassis : public Item
    Item *selectRandomItem( int flags = 0 );
 
    virtual ~Chassis();
-};
 
-struct BasicChassis : public Chassis
-{
-   BasicChassis();
-   virtual void drawEquipScreen( int selection );
-   virtual std::string getName();
+private:
+   unsigned char index[NUM_EQUIP_INDEXES][MAX_CHASSIS_SLOTS]; // slot numbers
+   unsigned char index_count[NUM_EQUIP_INDEXES];
 
-   virtual void drawDescription();
+   ItemSpan getIndex( EquipIndex which ) { return ItemSpan( slots, index[which], index_count[which] ); }
+   void addToIndex( EquipIndex which, int slot );
+   void rebuildIndexes();
 
-   virtual ~BasicChassis();
-};
-
-struct QuadChassis : public Chassis
-{
-   QuadChassis();
-   virtual void drawEquipScreen( int selection );
-   virtual std::string getName();
-
-   virtual void drawDescription();
-
-   virtual ~QuadChassis();
-};
-
-struct DomeChassis : public Chassis
-{
-   DomeChassis();
-   virtual void drawEquipScreen( int selection );
-   virtual std::string getName();
-
-   virtual void drawDescription();
-
-   virtual ~DomeChassis();
-};
-
-struct CritterChassis : public Chassis
-{
-   CritterChassis();
-   virtual void drawEquipScreen( int selection );
-   virtual std::string getName();
-
-   virtual void drawDescription();
-
-   virtual ~CritterChassis();
-};
-
-struct HeavyChassis : public Chassis
-{
-   HeavyChassis();
-   virtual void drawEquipScreen( int selection );
-   virtual std::string getName();
-
-   virtual void drawDescription();
-
-   virtual ~HeavyChassis();
-};
-
-struct OrbChassis : public Chassis
-{
-   OrbChassis();
-   virtual void drawEquipScreen( int selection );
-   virtual std::string getName();
-
-   virtual void drawDescription();
-
-   virtual ~OrbChassis();
-};
-
-// Arms
-
-struct Arm : public Item
-{
-   virtual int drawActions();
-   virtual int doAction( int selection );
-
-   virtual ~Arm();
-};
-
-struct ClawArm : public Arm
-{
-   ClawArm();
-   virtual int meleeAttack( Unit *target );
-   virtual std::string getName();
-
-   virtual void drawDescription();
-
-   virtual ~ClawArm();
-};
-
-struct HammerArm : public Arm
-{
-   HammerArm();
-   virtual int meleeAttack( Unit *target );
-   virtual std::string getName();
-
-   virtual void drawDescription();
-
-   virtual ~HammerArm();
-};
-
-struct ShockArm : public Arm
-{
-   ShockArm();
-   virtual int meleeAttack( Unit *target );
-   virtual std::string getName();
-
-   virtual void drawDescription();
-
-   virtual ~ShockArm();
-};
-
-struct EnergyLance : public Arm
-{
-   EnergyLance();
-   virtual int meleeAttack( Unit *target );
-   virtual std::string getName();
-
-   virtual void drawDescription();
-
-   virtual ~EnergyLance();
+   int firstSlot( ItemType slot_type );
+   int numSlots( ItemType slot_type );
+   int equip( Item *item, ItemType slot_type );
 };
 
 // Mounted items
 
-struct Mount : public Item
-{
-   virtual int drawActions();
-   virtual int doAction( int selection );
-
-   virtual ~Mount();
-};
-
-struct Laser : public Mount
+struct Laser : public Item
 {
    Laser();
-   virtual int rangedAttack( Unit *target );
-   virtual std::string getName();
-
-   virtual void drawDescription();
+   virtual int rangedAttack( Unit *attacker, Unit *target );
 
    virtual ~Laser();
 };
@@ -0,0 +1,217 @@
+#include "keymap.h"
+#include "defs.h"
+#include "log.h"
+
+#include <cstdio>
+#include <cstring>
+
+using namespace sf;
+
+// [state][key][shifted]
+static unsigned char keymap[NUM_GAME_STATES][Keyboard::KeyCount][2];
+
+void bindKey( GameState state, Keyboard::Key k, bool shift, GameCommand command )
+{
+   if (k < 0 || k >= Keyboard::KeyCount)
+      return;
+
+   keymap[state][k][shift ? 1 : 0] = (unsigned char) command;
+}
+
+GameCommand lookupKey( GameState state, Keyboard::Key k, int mod )
+{
+   if (k < 0 || k >= Keyboard::KeyCount)
+      return CMD_NONE;
+
+   const unsigned char *entry = keymap[state][k];
+   if ((mod & MOD_SHIFT) && entry[1] != CMD_NONE)
+      return (GameCommand) entry[1];
+   return (GameCommand) entry[0];
+}
+
+//////////////////////////////////////////////////////////////////////
+// Defaults
+//////////////////////////////////////////////////////////////////////
+
+static void bindMenuKeys( GameState s, bool paging )
+{
+   bindKey( s, Keyboard::Escape, false, CMD_CANCEL );
+   bindKey( s, Keyboard::BackSpace, false, CMD_CANCEL );
+   bindKey( s, Keyboard::Space, false, CMD_CONFIRM );
+   bindKey( s, Keyboard::Return, false, CMD_CONFIRM );
+   bindKey( s, Keyboard::Numpad8, false, CMD_UP );
+   bindKey( s, Keyboard::Up, false, CMD_UP );
+   bindKey( s, Keyboard::Numpad2, false, CMD_DOWN );
+   bindKey( s, Keyboard::Down, false, CMD_DOWN );
+
+   if (paging) {
+      bindKey( s, Keyboard::PageUp, false, CMD_PAGE_UP );
+      bindKey( s, Keyboard::PageDown, false, CMD_PAGE_DOWN );
+   }
+}
+
+static void bindDirectionKeys( GameState s )
+{
+   bindKey( s, Keyboard::Numpad1, false, CMD_SOUTHWEST );
+   bindKey( s, Keyboard::Numpad2, false, CMD_SOUTH );
+   bindKey( s, Keyboard::Numpad3, false, CMD_SOUTHEAST );
+   bindKey( s, Keyboard::Numpad4, false, CMD_WEST );
+   bindKey( s, Keyboard::Numpad6, false, CMD_EAST );
+   bindKey( s, Keyboard::Numpad7, false, CMD_NORTHWEST );
+   bindKey( s, Keyboard::Numpad8, false, CMD_NORTH );
+   bindKey( s, Keyboard::Numpad9, false, CMD_NORTHEAST );
+   bindKey( s, Keyboard::Down, false, CMD_SOUTH );
+   bindKey( s, Keyboard::Left, false, CMD_WEST );
+   bindKey( s, Keyboard::Right, false, CMD_EAST );
+   bindKey( s, Keyboard::Up, false, CMD_NORTH );
+}
+
+void initKeymap()
+{
+   memset( keymap, CMD_NONE, sizeof(keymap) );
+
+   bindDirectionKeys( ON_MAP );
+   bindKey( ON_MAP, Keyboard::E, false, CMD_EQUIP );
+   bindKey( ON_MAP, Keyboard::I, false, CMD_INVENTORY );
+   bindKey( ON_MAP, Keyboard::S, true, CMD_SAVE );
+   bindKey( ON_MAP, Keyboard::Comma, true, CMD_STAIRS_UP ); // '<'
+   bindKey( ON_MAP, Keyboard::Period, true, CMD_STAIRS_DOWN ); // '>'
+   bindKey( ON_MAP, Keyboard::Comma, false, CMD_PICK_UP );
+   bindKey( ON_MAP, Keyboard::F, false, CMD_FIRE );
+
+   bindMenuKeys( SELECTING_ABILITY, true );
+
+   bindDirectionKeys( TARGETTING );
+   bindKey( TARGETTING, Keyboard::Escape, false, CMD_CANCEL );
+   bindKey( TARGETTING, Keyboard::BackSpace, false, CMD_CANCEL );
+   bindKey( TARGETTING, Keyboard::Space, false, CMD_CONFIRM );
+   bindKey( TARGETTING, Keyboard::Return, false, CMD_CONFIRM );
+   bindKey( TARGETTING, Keyboard::N, false, CMD_NEXT_TARGET );
+   bindKey( TARGETTING, Keyboard::PageDown, false, CMD_NEXT_TARGET );
+   bindKey( TARGETTING, Keyboard::P, false, CMD_PREV_TARGET );
+   bindKey( TARGETTING, Keyboard::PageUp, false, CMD_PREV_TARGET );
+
+   bindKey( TEXT_PAUSE, Keyboard::Space, false, CMD_CONFIRM );
+   bindKey( TEXT_PAUSE, Keyboard::Return, false, CMD_CONFIRM );
+
+   bindMenuKeys( INVENTORY_SCREEN, true );
+   bindMenuKeys( INVENTORY_SELECT, false );
+   bindMenuKeys( EQUIP_SCREEN, false );
+   bindKey( EQUIP_SCREEN, Keyboard::E, false, CMD_CANCEL );
+   bindMenuKeys( EQUIP_INVENTORY, true );
+   bindMenuKeys( PICK_UP, true );
+}
+
+//////////////////////////////////////////////////////////////////////
+// Loading
+//////////////////////////////////////////////////////////////////////
+
+static const char *state_names[NUM_GAME_STATES] = {
+   "map", "ability", "target", "pause", "inventory", "inventory_select",
+   "equip", "equip_inventory", "pick_up", "help"
+};
+
+static const char *command_names[NUM_GAME_COMMANDS] = {
+   "none",
+   "cancel", "confirm", "up", "down", "page_up", "page_down",
+   "north", "northeast", "east", "southeast", "south", "southwest", "west", "northwest",
+   "next_target", "prev_target",
+   "equip", "inventory", "save", "stairs_up", "stairs_down", "pick_up", "fire"
+};
+
+struct KeyName
+{
+   const char *name;
+   Keyboard::Key key;
+};
+
+static const KeyName key_names[] = {
+   { "Escape", Keyboard::Escape }, { "Space", Keyboard::Space },
+   { "Return", Keyboard::Return }, { "BackSpace", Keyboard::BackSpace },
+   { "Tab", Keyboard::Tab }, { "PageUp", Keyboard::PageUp },
+   { "PageDown", Keyboard::PageDown }, { "Home", Keyboard::Home },
+   { "End", Keyboard::End }, { "Insert", Keyboard::Insert },
+   { "Delete", Keyboard::Delete }, { "Left", Keyboard::Left },
+   { "Right", Keyboard::Right }, { "Up", Keyboard::Up },
+   { "Down", Keyboard::Down }, { "Comma", Keyboard::Comma },
+   { "Period", Keyboard::Period }, { "Slash", Keyboard::Slash },
+   { "SemiColon", Keyboard::SemiColon }, { "Dash", Keyboard::Dash },
+   { "Equal", Keyboard::Equal },
+   { NULL, Keyboard::Unknown }
+};
+
+static int findName( const char *name, const char **names, int count )
+{
+   for (int i = 0; i < count; ++i) {
+      if (strcmp( name, names[i] ) == 0)
+         return i;
+   }
+   return -1;
+}
+
+static Keyboard::Key findKey( const char *name )
+{
+   // Letters, digits, numpad and function keys are contiguous in Keyboard::Key
+   if (name[0] >= 'A' && name[0] <= 'Z' && name[1] == '\0')
+      return (Keyboard::Key) (Keyboard::A + (name[0] - 'A'));
+   if (name[0] >= '0' && name[0] <= '9' && name[1] == '\0')
+      return (Keyboard::Key) (Keyboard::Num0 + (name[0] - '0'));
+   if (strncmp( name, "Numpad", 6 ) == 0 && name[6] >= '0' && name[6] <= '9' && name[7] == '\0')
+      return (Keyboard::Key) (Keyboard::Numpad0 + (name[6] - '0'));
+
+   int f;
+   char tail;
+   if (sscanf( name, "F%d%c", &f, &tail ) == 1 && f >= 1 && f <= 15)
+      return (Keyboard::Key) (Keyboard::F1 + (f - 1));
+
+   for (int i = 0; key_names[i].name != NULL; ++i) {
+      if (strcmp( name, key_names[i].name ) == 0)
+         return key_names[i].key;
+   }
+   return Keyboard::Unknown;
+}
+
+int loadKeymap( const char *path )
+{
+   FILE *f = fopen( path, "r" );
+   if (f == NULL)
+      return -1;
+
+   char line[256];
+   int line_number = 0;
+   while (fgets( line, sizeof(line), f ) != NULL) {
+      line_number++;
+
+      char state_name[64], key_name[64], command_name[64];
+      int fields = sscanf( line, "%63s %63s %63s", state_name, key_name, command_name );
+      if (fields <= 0 || state_name[0] == '#')
+         continue;
+
+      const char *key_part = key_name;
+      bool shift = false;
+      if (strncmp( key_name, "Shift+", 6 ) == 0) {
+         key_part += 6;
+         shift = true;
+      }
+
+      int state = -1, command = -1;
+      Keyboard::Key k = Keyboard::Unknown;
+      if (fields == 3) {
+         state = findName( state_name, state_names, NUM_GAME_STATES );
+         command = findName( command_name, command_names, NUM_GAME_COMMANDS );
+         k = findKey( key_part );
+      }
+
+      if (state == -1 || command == -1 || k == Keyboard::Unknown) {
+         char msg[96];
+         snprintf( msg, sizeof(msg), "%s:%d: bad key binding", path, line_number );
+         log( msg, LOG_LEVEL_WARNING );
+         continue;
+      }
+
+      bindKey( (GameState) state, k, shift, (GameCommand) command );
+   }
+
+   fclose( f );
+   return 0;
+}
@@ -0,0 +1,84 @@
+#ifndef KEYMAP_H__
+#define KEYMAP_H__
+
+/* Key bindings.
+ *
+ * Each GameState has its own table mapping a key, with or without shift,
+ * to a GameCommand.  sendKeyToGame() looks the key up and hands the
+ * command to that state's handler, so rebinding a key never touches the
+ * game code.  A shifted key with no binding of its own falls back to the
+ * unshifted one.
+ *
+ * The defaults are set by initKeymap(); loadKeymap() then applies any
+ * rebindings from a text file, one per line:
+ *
+ *    <state> [Shift+]<key> <command>
+ *
+ * e.g. "map Shift+X save" or "target Tab next_target".  Lines starting
+ * with '#' are ignored.  The names are in keymap.cpp.
+ */
+
+#include <SFML/Window.hpp>
+
+#define DEFAULT_KEYMAP_FILE "keys.cfg"
+
+enum GameState
+{
+   ON_MAP,
+   SELECTING_ABILITY,
+   TARGETTING,
+   TEXT_PAUSE,
+   INVENTORY_SCREEN,
+   INVENTORY_SELECT,
+   EQUIP_SCREEN,
+   EQUIP_INVENTORY,
+   PICK_UP,
+   HELP_SCREEN,
+
+   NUM_GAME_STATES
+};
+
+enum GameCommand
+{
+   CMD_NONE,
+
+   // Menus
+   CMD_CANCEL,
+   CMD_CONFIRM,
+   CMD_UP,
+   CMD_DOWN,
+   CMD_PAGE_UP,
+   CMD_PAGE_DOWN,
+
+   // Same order as Direction
+   CMD_NORTH,
+   CMD_NORTHEAST,
+   CMD_EAST,
+   CMD_SOUTHEAST,
+   CMD_SOUTH,
+   CMD_SOUTHWEST,
+   CMD_WEST,
+   CMD_NORTHWEST,
+
+   CMD_NEXT_TARGET,
+   CMD_PREV_TARGET,
+
+   CMD_EQUIP,
+   CMD_INVENTORY,
+   CMD_SAVE,
+   CMD_STAIRS_UP,
+   CMD_STAIRS_DOWN,
+   CMD_PICK_UP,
+   CMD_FIRE,
+
+   NUM_GAME_COMMANDS
+};
+
+void initKeymap();
+// 0 on success, -1 if the file can't be opened; bad lines are logged and skipped
+int loadKeymap( const char *path = DEFAULT_KEYMAP_FILE );
+
+void bindKey( GameState state, sf::Keyboard::Key k, bool shift, GameCommand command );
+GameCommand lookupKey( GameState state, sf::Keyboard::Key k, int mod );
+
+#endif
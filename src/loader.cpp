@@ -0,0 +1,165 @@
+#include "loader.h"
+#include "log.h"
+
+#include "SFML_TextureManager.hpp"
+
+#include <SFML/System.hpp>
+#include <SFML/Graphics.hpp>
+
+#include <cstdio>
+#include <vector>
+#include <deque>
+
+struct AssetJob
+{
+   AssetType type;
+   std::string path;
+   long bytes;
+   sf::Image *image; // Decoded, or NULL if it failed
+};
+
+// Not resized while the workers run, so they can hold references into it
+static std::vector<AssetJob> jobs;
+
+static sf::Mutex loader_mutex;
+static unsigned int next_job = 0;          // guarded by loader_mutex
+static std::deque<unsigned int> decoded;   // guarded by loader_mutex
+
+// Main thread only
+static std::vector<sf::Thread*> workers;
+static unsigned int jobs_finished = 0;
+static long total_bytes = 0, finished_bytes = 0;
+static sf::Clock load_clock;
+
+static long fileSize( const std::string &path )
+{
+   FILE *f = fopen( path.c_str(), "rb" );
+   if (f == NULL)
+      return 0;
+
+   fseek( f, 0, SEEK_END );
+   long size = ftell( f );
+   fclose( f );
+   return (size > 0) ? size : 0;
+}
+
+void queueAsset( AssetType type, const std::string &path )
+{
+   AssetJob job;
+   job.type = type;
+   job.path = path;
+   job.bytes = fileSize( "res/" + path );
+   job.image = NULL;
+
+   jobs.push_back( job );
+   total_bytes += job.bytes;
+}
+
+static void assetWorker()
+{
+   while (true) {
+      unsigned int i;
+      {
+         sf::Lock lock( loader_mutex );
+         if (next_job >= jobs.size())
+            return;
+         i = next_job++;
+      }
+
+      AssetJob &job = jobs[i];
+      if (job.type == ASSET_TEXTURE) {
+         job.image = new sf::Image();
+         if (!job.image->loadFromFile( "res/" + job.path )) {
+            delete job.image;
+            job.image = NULL;
+         }
+      }
+
+      sf::Lock lock( loader_mutex );
+      decoded.push_back( i );
+   }
+}
+
+void startAssetLoader( int threads )
+{
+   load_clock.restart();
+
+   // No point having more workers than work
+   if (threads > (int) jobs.size())
+      threads = jobs.size();
+
+   for (int i = 0; i < threads; ++i) {
+      sf::Thread *worker = new sf::Thread( &assetWorker );
+      workers.push_back( worker );
+      worker->launch();
+   }
+}
+
+bool finishLoadedAssets()
+{
+   std::deque<unsigned int> ready;
+   {
+      sf::Lock lock( loader_mutex );
+      ready.swap( decoded );
+   }
+
+   for (unsigned int r = 0; r < ready.size(); ++r) {
+      AssetJob &job = jobs[ready[r]];
+
+      if (job.image == NULL) {
+         log("Couldn't load asset: res/" + job.path, LOG_LEVEL_ERROR);
+      }
+      else {
+         // The manager owns the image from here, whether or not it takes it
+         SFML_TextureManager &textures = SFML_TextureManager::getSingleton();
+         if (!textures.addImage( job.path, job.image ))
+            log("Couldn't make a texture from: res/" + job.path, LOG_LEVEL_ERROR);
+         textures.internTexture( job.path );
+         job.image = NULL;
+      }
+
+      jobs_finished++;
+      finished_bytes += job.bytes;
+   }
+
+   if (jobs_finished < jobs.size())
+      return false;
+
+   if (!ready.empty()) {
+      if (!SFML_TextureManager::getSingleton().buildAtlases())
+         log("Couldn't pack every image into the texture atlases", LOG_LEVEL_ERROR);
+
+      char msg[96];
+      snprintf( msg, sizeof(msg), "Loaded %u assets (%ld bytes) in %dms",
+            jobs_finished, total_bytes, load_clock.getElapsedTime().asMilliseconds() );
+      log( msg );
+   }
+   return true;
+}
+
+float assetLoadProgress()
+{
+   if (total_bytes == 0)
+      return jobs.empty() ? 1.f : (float) jobs_finished / jobs.size();
+
+   return (float) finished_bytes / total_bytes;
+}
+
+void stopAssetLoader()
+{
+   for (unsigned int i = 0; i < workers.size(); ++i) {
+      workers[i]->wait();
+      delete workers[i];
+   }
+   workers.clear();
+
+   // Anything decoded but never collected
+   for (unsigned int i = 0; i < jobs.size(); ++i)
+      delete jobs[i].image;
+
+   jobs.clear();
+   decoded.clear();
+   next_job = 0;
+   jobs_finished = 0;
+   total_bytes = finished_bytes = 0;
+}
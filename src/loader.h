@@ -0,0 +1,38 @@
+#ifndef LOADER_H__
+#define LOADER_H__
+
+/* Loading assets in the background.
+ *
+ * Assets are queued up front, then startAssetLoader() reads and decodes
+ * them on worker threads.  Only the main thread may touch OpenGL, so the
+ * decoded images wait there until finishLoadedAssets() - called once per
+ * frame of the loading screen - hands them to the SFML_TextureManager under
+ * the path they were queued with.  With the manager in atlas mode they're
+ * packed into atlases once the last one is in.  Each path is interned as it
+ * arrives, so drawing code can keep a TextureHandle from internTexture()
+ * rather than looking the path up every frame.
+ * Progress
+ * is measured in file bytes, so one big image counts for as much as the
+ * many small ones it outweighs.
+ */
+
+#include <string>
+
+enum AssetType {
+   ASSET_TEXTURE,
+
+   NUM_ASSET_TYPES
+};
+
+// Paths are relative to res/.  Only before startAssetLoader().
+void queueAsset( AssetType type, const std::string &path );
+
+void startAssetLoader( int threads = 2 );
+// Uploads whatever has been decoded; true once every asset is done with
+bool finishLoadedAssets();
+// 0 to 1, by bytes
+float assetLoadProgress();
+// Waits for the workers and forgets the queue
+void stopAssetLoader();
+
+#endif
@@ -1,21 +1,181 @@
 #include <string>
-#include <fstream>
+#include <cstdio>
+#include <cstring>
+#include <cstdlib>
 #include "log.h"
 
+#include <SFML/System.hpp>
+
 using namespace std;
 
-ofstream logfile;
+#define LOG_RING_SIZE 1024
+#define LOG_TEXT_SIZE 200
 
-void log( string out )
+struct LogRecord
 {
-   static int init = 0;
+   LogLevel level;
+   unsigned long tick;
+   bool has_tick;
+   float seconds;
+   char text[LOG_TEXT_SIZE];
+};
+
+/* Records [log_head - log_count, log_head) are waiting to be written.  The
+ * writer only takes the indices under the lock and frees the records once
+ * it's written them, so log() never writes into a record being read.
+ */
+static LogRecord log_ring[LOG_RING_SIZE];
+static unsigned int log_head = 0, log_count = 0; // guarded by log_mutex
+static unsigned int log_dropped = 0;             // guarded by log_mutex
+static bool log_stopping = false;                // guarded by log_mutex
+static sf::Mutex log_mutex;
+
+static sf::Thread *log_thread = NULL;
+static sf::ThreadLocalPtr<const unsigned long> log_ticks( NULL );
+
+static FILE *logfile = NULL;
+
+static sf::Clock& logClock()
+{
+   static sf::Clock clock;
+   return clock;
+}
 
-   if (!init) {
-      logfile.open(".log");
-      init = 1;
+static const char* levelName( LogLevel level )
+{
+   switch (level) {
+      case LOG_LEVEL_DEBUG: return "DEBUG";
+      case LOG_LEVEL_INFO: return "INFO ";
+      case LOG_LEVEL_WARNING: return "WARN ";
+      case LOG_LEVEL_ERROR: return "ERROR";
+   }
+   return "?    ";
+}
+
+// Only ever called by one thread at a time: the writer, or whoever
+// stops it once it's gone
+static void writeRecords( unsigned int first, unsigned int count, unsigned int dropped )
+{
+   if (logfile == NULL) {
+      logfile = fopen( ".log", "w" );
+      if (logfile == NULL)
+         return;
    }
 
-   logfile << out << endl;
+   for (unsigned int i = 0; i < count; ++i) {
+      const LogRecord &r = log_ring[(first + i) % LOG_RING_SIZE];
+      if (r.has_tick)
+         fprintf( logfile, "[%9.3fs t=%lu] %s %s\n", r.seconds, r.tick, levelName( r.level ), r.text );
+      else
+         fprintf( logfile, "[%9.3fs] %s %s\n", r.seconds, levelName( r.level ), r.text );
+   }
+   if (dropped > 0)
+      fprintf( logfile, "[log] %u records dropped, the ring was full\n", dropped );
+
+   fflush( logfile );
+}
+
+/* Writes everything waiting in the ring, oldest first.  The lock is only
+ * held to read and then advance the indices, not while formatting.
+ */
+static void drainRing()
+{
+   unsigned int first, count, dropped;
+   {
+      sf::Lock lock( log_mutex );
+      count = log_count;
+      first = (log_head + LOG_RING_SIZE - log_count) % LOG_RING_SIZE;
+      dropped = log_dropped;
+      log_dropped = 0;
+   }
+
+   if (count == 0 && dropped == 0)
+      return;
+   writeRecords( first, count, dropped );
+
+   sf::Lock lock( log_mutex );
+   log_count -= count;
 }
 
+static void logWriterLoop()
+{
+   while (true) {
+      bool stop;
+      {
+         sf::Lock lock( log_mutex );
+         stop = log_stopping;
+      }
+
+      drainRing();
 
+      if (stop)
+         break;
+
+      sf::sleep( sf::milliseconds( 50 ) );
+   }
+}
+
+void log( const char *out, LogLevel level )
+{
+   float seconds = logClock().getElapsedTime().asSeconds();
+
+   // Snapshot the tick here, on the thread that owns it
+   const unsigned long *tick_source = log_ticks;
+   unsigned long tick = (tick_source != NULL) ? *tick_source : 0;
+
+   sf::Lock lock( log_mutex );
+
+   if (log_count == LOG_RING_SIZE) {
+      log_dropped++;
+      return;
+   }
+
+   LogRecord &r = log_ring[log_head];
+   r.level = level;
+   r.has_tick = (tick_source != NULL);
+   r.tick = tick;
+   r.seconds = seconds;
+   strncpy( r.text, out, LOG_TEXT_SIZE - 1 );
+   r.text[LOG_TEXT_SIZE - 1] = '\0';
+
+   log_head = (log_head + 1) % LOG_RING_SIZE;
+   log_count++;
+}
+
+void log( const string &out, LogLevel level )
+{
+   log( out.c_str(), level );
+}
+
+void setLogTickSource( const unsigned long *ticks )
+{
+   log_ticks = ticks;
+}
+
+void startLogger()
+{
+   if (log_thread != NULL)
+      return;
+
+   logClock().restart();
+   log_stopping = false;
+   log_thread = new sf::Thread( &logWriterLoop );
+   log_thread->launch();
+   atexit( stopLogger );
+}
+
+void stopLogger()
+{
+   if (log_thread != NULL) {
+      {
+         sf::Lock lock( log_mutex );
+         log_stopping = true;
+      }
+      log_thread->wait();
+      delete log_thread;
+      log_thread = NULL;
+   }
+
+   // Anything logged after the thread stopped, or without it ever starting
+   drainRing();
+}
@@ -1,8 +1,42 @@
 #ifndef LOG_H__
 #define LOG_H__
 
+/* Logging to .log
+ *
+ * log() only copies the message into a fixed-size ring of records and
+ * returns; a background thread (startLogger) formats and writes them in
+ * batches, so logging never waits on the disk.  Each record is stamped
+ * with the wall clock since startup and, when logged from the thread that
+ * set the tick source, the game tick.  If the ring fills faster than the
+ * writer can drain it, new records are dropped and counted rather than
+ * blocking the caller.
+ *
+ * LOG_DEBUG compiles to nothing unless ROBOTRL_DEBUG_LOG is defined.
+ */
+
 #include <string>
 
-void log( std::string out );
+enum LogLevel {
+   LOG_LEVEL_DEBUG,
+   LOG_LEVEL_INFO,
+   LOG_LEVEL_WARNING,
+   LOG_LEVEL_ERROR
+};
+
+void log( const std::string &out, LogLevel level = LOG_LEVEL_INFO );
+void log( const char *out, LogLevel level = LOG_LEVEL_INFO );
+
+#ifdef ROBOTRL_DEBUG_LOG
+#define LOG_DEBUG( out ) log( (out), LOG_LEVEL_DEBUG )
+#else
+#define LOG_DEBUG( out ) ((void) 0)
+#endif
+
+// Only the calling thread's records get ticks; other threads never read it
+void setLogTickSource( const unsigned long *ticks );
+
+void startLogger();
+// Writes out everything still waiting and stops the writer thread
+void stopLogger();
 
 #endif
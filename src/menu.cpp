@@ -31,8 +31,12 @@ void displayMenu()
    }
    else if (which_menu == 2) {
       writeString("Test Level", MenuFG, MenuBG, 35, 14); 
+      writeString("Load Game", MenuFG, MenuBG, 35, 15);
 
       int inv_row = 14;
+      if (menu_selection == 2)
+         inv_row = 15;
+
       colorInvert( 33, inv_row, 46, inv_row );
 
       drawDisplay();
@@ -69,9 +73,11 @@ int sendKeyToMenu( Keyboard::Key k , int mod )
       }
       else if (which_menu == 2) {
           if (menu_selection == 1) {
-             // Start test level
-             testLevel();
+             newGame();
              return 1;
+          } else if (menu_selection == 2) {
+             if (loadGame() == 0)
+                return 1;
           }
       }
    }
@@ -0,0 +1,198 @@
+#include "pool.h"
+#include "log.h"
+
+#include <new>
+#include <sstream>
+
+int allocation_arena = PERSISTENT_ARENA;
+
+// Objects are 16-byte aligned and sized in 16-byte steps
+const size_t pool_granularity = 16;
+const size_t max_pooled_size = 1024;
+
+struct ObjectPool::Block
+{
+   ObjectPool *pool;
+   Block *next_free;
+   int arena;
+   bool live;
+};
+
+// Header space in front of each object, rounded up to keep objects aligned
+const size_t header_size =
+   ((sizeof(ObjectPool::Block) + pool_granularity - 1) / pool_granularity) * pool_granularity;
+
+static ObjectPool::Block* headerOf( void *object )
+{
+   return (ObjectPool::Block*) ((char*) object - header_size);
+}
+
+ObjectPool::ObjectPool( size_t object_size, unsigned int b_p_s )
+{
+   block_size = header_size + object_size;
+   blocks_per_slab = b_p_s;
+   free_list = NULL;
+}
+
+ObjectPool::~ObjectPool()
+{
+   for (unsigned int i = 0; i < slabs.size(); ++i)
+      ::operator delete( slabs[i] );
+}
+
+void ObjectPool::addSlab()
+{
+   char *slab = (char*) ::operator new( block_size * blocks_per_slab );
+   slabs.push_back( slab );
+
+   // Thread the new blocks onto the free list in address order
+   for (int i = blocks_per_slab - 1; i >= 0; --i) {
+      Block *b = (Block*) (slab + i * block_size);
+      b->pool = this;
+      b->live = false;
+      b->arena = PERSISTENT_ARENA;
+      b->next_free = free_list;
+      free_list = b;
+   }
+
+   stats.slabs++;
+   stats.capacity += blocks_per_slab;
+   stats.bytes += block_size * blocks_per_slab;
+}
+
+void* ObjectPool::allocate( int arena )
+{
+   if (free_list == NULL)
+      addSlab();
+
+   Block *b = free_list;
+   free_list = b->next_free;
+
+   b->next_free = NULL;
+   b->arena = arena;
+   b->live = true;
+
+   stats.in_use++;
+   if (stats.in_use > stats.peak)
+      stats.peak = stats.in_use;
+
+   return (char*) b + header_size;
+}
+
+void ObjectPool::release( void *object )
+{
+   if (object == NULL)
+      return;
+
+   Block *b = headerOf( object );
+   ObjectPool *pool = b->pool;
+
+   if (!b->live) {
+      log("ObjectPool: double release of a pooled object", LOG_LEVEL_ERROR);
+      return;
+   }
+
+   b->live = false;
+   b->next_free = pool->free_list;
+   pool->free_list = b;
+   pool->stats.in_use--;
+}
+
+int ObjectPool::getArena( void *object )
+{
+   return headerOf( object )->arena;
+}
+
+void ObjectPool::setArena( void *object, int arena )
+{
+   headerOf( object )->arena = arena;
+}
+
+void ObjectPool::collectArena( int arena, std::vector<void*> &out )
+{
+   for (unsigned int s = 0; s < slabs.size(); ++s) {
+      for (unsigned int i = 0; i < blocks_per_slab; ++i) {
+         Block *b = (Block*) (slabs[s] + i * block_size);
+         if (b->live && b->arena == arena)
+            out.push_back( (char*) b + header_size );
+      }
+   }
+}
+
+//////////////////////////////////////////////////////////////////////
+// PoolFamily
+//////////////////////////////////////////////////////////////////////
+
+PoolFamily::PoolFamily( std::string n )
+{
+   name = n;
+   pools.resize( max_pooled_size / pool_granularity, NULL );
+}
+
+PoolFamily::~PoolFamily()
+{
+   for (unsigned int i = 0; i < pools.size(); ++i)
+      delete pools[i];
+}
+
+void* PoolFamily::allocate( size_t size )
+{
+   if (size == 0) size = 1;
+
+   size_t size_class = (size - 1) / pool_granularity;
+   if (size_class >= pools.size()) {
+      log("PoolFamily: object too large to pool", LOG_LEVEL_ERROR);
+      throw std::bad_alloc();
+   }
+
+   if (pools[size_class] == NULL)
+      pools[size_class] = new ObjectPool( (size_class + 1) * pool_granularity );
+
+   return pools[size_class]->allocate( allocation_arena );
+}
+
+void PoolFamily::collectArena( int arena, std::vector<void*> &out )
+{
+   for (unsigned int i = 0; i < pools.size(); ++i) {
+      if (pools[i] != NULL)
+         pools[i]->collectArena( arena, out );
+   }
+}
+
+PoolStats PoolFamily::getStats()
+{
+   PoolStats total;
+   for (unsigned int i = 0; i < pools.size(); ++i) {
+      if (pools[i] == NULL)
+         continue;
+
+      const PoolStats &s = pools[i]->getStats();
+      total.slabs += s.slabs;
+      total.capacity += s.capacity;
+      total.in_use += s.in_use;
+      total.peak += s.peak;
+      total.bytes += s.bytes;
+   }
+   return total;
+}
+
+std::string PoolFamily::describe()
+{
+   PoolStats s = getStats();
+   std::stringstream ss;
+   ss << name << " pool: " << s.in_use << "/" << s.capacity << " blocks in use"
+      << " (peak " << s.peak << "), " << s.slabs << " slabs, " << s.bytes << " bytes";
+   return ss.str();
+}
+
+PoolFamily& itemPool()
+{
+   static PoolFamily pool( "Item" );
+   return pool;
+}
+
+PoolFamily& unitPool()
+{
+   static PoolFamily pool( "Unit" );
+   return pool;
+}
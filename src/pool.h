@@ -0,0 +1,87 @@
+#ifndef POOL_H__
+#define POOL_H__
+
+/* Slab allocation for Items and Units.
+ *
+ * Item and Unit override operator new/delete to take their memory from a
+ * PoolFamily, which keeps one ObjectPool per 16-byte size class.  Each pool
+ * carves fixed-size blocks out of large slabs and recycles them through a
+ * free list, so equipping a unit or killing one never touches the heap.
+ *
+ * Every block is also tagged with an arena number.  New objects get the
+ * current value of allocation_arena (normally the level being built), and
+ * collectArena() hands back everything with a given tag so a whole level's
+ * objects can be torn down in one pass.  Arena 0 is the persistent arena,
+ * for things that travel with the player.
+ */
+
+#include <cstddef>
+#include <vector>
+#include <string>
+
+#define PERSISTENT_ARENA 0
+
+extern int allocation_arena; // Arena tag given to newly allocated objects
+
+struct PoolStats
+{
+   unsigned int slabs;
+   unsigned int capacity; // blocks
+   unsigned int in_use;
+   unsigned int peak;
+   size_t bytes; // total slab memory
+
+   PoolStats() { slabs = capacity = in_use = peak = 0; bytes = 0; }
+};
+
+class ObjectPool
+{
+public:
+   struct Block;
+
+private:
+   size_t block_size; // including header
+   unsigned int blocks_per_slab;
+   std::vector<char*> slabs;
+   Block *free_list;
+   PoolStats stats;
+
+   void addSlab();
+
+public:
+   ObjectPool( size_t object_size, unsigned int blocks_per_slab = 64 );
+   ~ObjectPool();
+
+   void* allocate( int arena );
+   static void release( void *object );
+
+   static int getArena( void *object );
+   static void setArena( void *object, int arena );
+
+   // Appends every live object tagged with 'arena' to 'out'
+   void collectArena( int arena, std::vector<void*> &out );
+
+   const PoolStats& getStats() const { return stats; }
+};
+
+class PoolFamily
+{
+   std::string name;
+   std::vector<ObjectPool*> pools; // indexed by size class
+
+public:
+   PoolFamily( std::string n );
+   ~PoolFamily();
+
+   void* allocate( size_t size );
+
+   void collectArena( int arena, std::vector<void*> &out );
+
+   PoolStats getStats();
+   std::string describe();
+};
+
+PoolFamily& itemPool();
+PoolFamily& unitPool();
+
+#endif
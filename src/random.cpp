@@ -0,0 +1,60 @@
+#include "random.h"
+
+static Random streams[NUM_RNG_STREAMS];
+static uint64_t master_seed = 0;
+
+Random::Random()
+{
+   seed( 0, 0 );
+}
+
+void Random::seed( uint64_t s, uint64_t stream )
+{
+   state = 0;
+   inc = (stream << 1) | 1;
+   next();
+   state += s;
+   next();
+}
+
+uint32_t Random::next()
+{
+   uint64_t old = state;
+   state = old * 6364136223846793005ULL + inc;
+
+   uint32_t xorshifted = (uint32_t) (((old >> 18) ^ old) >> 27);
+   uint32_t rot = (uint32_t) (old >> 59);
+   return (xorshifted >> rot) | (xorshifted << ((-rot) & 31));
+}
+
+int Random::below( int n )
+{
+   if (n <= 0)
+      return 0;
+
+   // Throw away the top sliver of the range that doesn't divide evenly
+   uint32_t bound = (uint32_t) n;
+   uint32_t threshold = (uint32_t) (-bound) % bound;
+   for (;;) {
+      uint32_t r = next();
+      if (r >= threshold)
+         return r % bound;
+   }
+}
+
+void seedRandom( uint64_t seed )
+{
+   master_seed = seed;
+   for (int s = 0; s < NUM_RNG_STREAMS; ++s)
+      streams[s].seed( seed, s + 1 );
+}
+
+uint64_t getRandomSeed()
+{
+   return master_seed;
+}
+
+Random& rng( RandomStream stream )
+{
+   return streams[stream];
+}
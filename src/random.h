@@ -0,0 +1,48 @@
+#ifndef RANDOM_H__
+#define RANDOM_H__
+
+/* Random numbers for the game.
+ *
+ * Each subsystem draws from its own stream, so how often combat rolls has
+ * no effect on where the AI wanders or how levels are built.  All streams
+ * come from one master seed: seeding with the same value replays the same
+ * game.  Each stream is a PCG32 generator - small, fast, and good enough
+ * for anything a roguelike needs.  Nothing here is shared between streams,
+ * so a stream can be handed to a worker thread as long as only that thread
+ * uses it.
+ */
+
+#include <stdint.h>
+
+enum RandomStream {
+   COMBAT_RNG,
+   AI_RNG,
+   LEVELGEN_RNG,
+
+   NUM_RNG_STREAMS
+};
+
+class Random
+{
+   uint64_t state;
+   uint64_t inc;
+
+public:
+   Random();
+
+   void seed( uint64_t seed, uint64_t stream );
+
+   uint32_t next();
+
+   // Uniform in [0, n), with no modulo bias.  0 if n <= 0.
+   int below( int n );
+   // true one time in n
+   bool oneIn( int n ) { return below( n ) == 0; }
+};
+
+void seedRandom( uint64_t seed );
+uint64_t getRandomSeed();
+
+Random& rng( RandomStream stream );
+
+#endif
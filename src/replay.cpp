@@ -0,0 +1,210 @@
+#include "replay.h"
+#include "log.h"
+
+#include <cstdio>
+#include <string>
+#include <vector>
+
+static const char replay_magic[4] = { 'R', 'J', 'R', 'P' };
+
+//////////////////////////////////////////////////////////////////////
+// Recording
+//////////////////////////////////////////////////////////////////////
+
+static std::string record_path;
+static FILE *record_file = NULL;
+static unsigned long last_record_tick = 0;
+
+static void writeBytes( uint64_t value, int bytes )
+{
+   for (int i = 0; i < bytes; ++i)
+      fputc( (int) ((value >> (8 * i)) & 0xFF), record_file );
+}
+
+static void writeVarint( uint64_t value )
+{
+   while (value >= 0x80) {
+      fputc( (int) ((value & 0x7F) | 0x80), record_file );
+      value >>= 7;
+   }
+   fputc( (int) value, record_file );
+}
+
+// The file isn't opened until a new game gives it a seed
+int startRecording( const char *path )
+{
+   stopRecording();
+
+   if (path == NULL || path[0] == '\0')
+      return -1;
+   record_path = path;
+   return 0;
+}
+
+bool recording()
+{
+   return !record_path.empty();
+}
+
+void recordSeed( uint64_t seed )
+{
+   if (record_path.empty())
+      return;
+
+   if (record_file != NULL)
+      fclose( record_file );
+   record_file = fopen( record_path.c_str(), "wb" );
+   if (record_file == NULL) {
+      log("Couldn't open replay file for writing: " + record_path, LOG_LEVEL_ERROR);
+      record_path.clear();
+      return;
+   }
+
+   fwrite( replay_magic, 1, sizeof(replay_magic), record_file );
+   writeBytes( REPLAY_VERSION, 2 );
+   writeBytes( seed, 8 );
+   last_record_tick = 0;
+}
+
+void recordKey( unsigned long tick, int key, int command )
+{
+   if (record_file == NULL)
+      return;
+
+   writeVarint( tick - last_record_tick );
+   fputc( key & 0xFF, record_file );
+   fputc( command & 0xFF, record_file );
+   last_record_tick = tick;
+
+   // A crash is when a replay matters most, so don't leave keys in a buffer
+   fflush( record_file );
+}
+
+void stopRecording()
+{
+   if (record_file != NULL) {
+      fclose( record_file );
+      record_file = NULL;
+   }
+   record_path.clear();
+}
+
+//////////////////////////////////////////////////////////////////////
+// Playback
+//////////////////////////////////////////////////////////////////////
+
+// The whole replay is read up front, so playback never waits on the disk
+static std::vector<unsigned char> replay_data;
+static unsigned int replay_pos = 0;
+static bool replay_open = false;
+static uint64_t replay_seed = 0;
+static unsigned long replay_tick = 0;
+
+static bool readBytes( uint64_t &value, int bytes )
+{
+   if (replay_pos + bytes > replay_data.size())
+      return false;
+
+   value = 0;
+   for (int i = 0; i < bytes; ++i)
+      value |= ((uint64_t) replay_data[replay_pos++]) << (8 * i);
+   return true;
+}
+
+static bool readVarint( uint64_t &value )
+{
+   value = 0;
+   for (int shift = 0; shift < 64; shift += 7) {
+      if (replay_pos >= replay_data.size())
+         return false;
+
+      unsigned char b = replay_data[replay_pos++];
+      value |= ((uint64_t) (b & 0x7F)) << shift;
+      if (!(b & 0x80))
+         return true;
+   }
+   return false;
+}
+
+int openReplay( const char *path )
+{
+   closeReplay();
+
+   FILE *f = fopen( path, "rb" );
+   if (f == NULL) {
+      log(std::string("Couldn't open replay file: ") + path, LOG_LEVEL_ERROR);
+      return -1;
+   }
+
+   unsigned char buf[4096];
+   size_t n;
+   while ((n = fread( buf, 1, sizeof(buf), f )) > 0)
+      replay_data.insert( replay_data.end(), buf, buf + n );
+   fclose( f );
+
+   uint64_t version;
+   if (replay_data.size() < sizeof(replay_magic)
+         || replay_data[0] != replay_magic[0] || replay_data[1] != replay_magic[1]
+         || replay_data[2] != replay_magic[2] || replay_data[3] != replay_magic[3]) {
+      log(std::string("Not a replay file: ") + path, LOG_LEVEL_ERROR);
+      closeReplay();
+      return -2;
+   }
+   replay_pos = sizeof(replay_magic);
+
+   if (!readBytes( version, 2 ) || version != REPLAY_VERSION) {
+      log("Replay file is from an unsupported version", LOG_LEVEL_ERROR);
+      closeReplay();
+      return -3;
+   }
+   if (!readBytes( replay_seed, 8 )) {
+      log("Replay file is truncated", LOG_LEVEL_ERROR);
+      closeReplay();
+      return -4;
+   }
+
+   replay_tick = 0;
+   replay_open = true;
+   return 0;
+}
+
+bool replaying()
+{
+   return replay_open;
+}
+
+uint64_t replaySeed()
+{
+   return replay_seed;
+}
+
+bool nextReplayKey( unsigned long &tick, int &key, int &command )
+{
+   if (!replay_open)
+      return false;
+
+   if (replay_pos >= replay_data.size())
+      return false;
+
+   // The game may have died partway through writing the last key
+   uint64_t delta, k, c;
+   if (!readVarint( delta ) || !readBytes( k, 1 ) || !readBytes( c, 1 )) {
+      log("Replay file ends partway through a key; ignoring it", LOG_LEVEL_WARNING);
+      replay_pos = replay_data.size();
+      return false;
+   }
+
+   replay_tick += delta;
+   tick = replay_tick;
+   key = (int) k;
+   command = (int) c;
+   return true;
+}
+
+void closeReplay()
+{
+   replay_data.clear();
+   replay_pos = 0;
+   replay_open = false;
+   replay_seed = 0;
+}
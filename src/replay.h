@@ -0,0 +1,52 @@
+#ifndef REPLAY_H__
+#define REPLAY_H__
+
+/* Input replays.
+ *
+ * Given the random seed and every key the game acted on, along with the
+ * tick it arrived on, a game plays out exactly the same way again.  A
+ * replay file holds just that:
+ *
+ *    "RJRP"            magic
+ *    u16               version
+ *    u64               seed
+ *    then per key:
+ *       varint         ticks since the previous key
+ *       u8             sf::Keyboard::Key
+ *       u8             GameCommand the keymap resolved it to
+ *
+ * The key is only kept for menus where letters pick entries; everything
+ * else replays the recorded command, so a replay doesn't depend on the
+ * keys.cfg it's played back with.
+ *
+ * All integers are little-endian; a varint is 7 bits per byte, low bits
+ * first, with the top bit set on every byte but the last.  Each key is
+ * flushed as it's recorded, and a partly written last key is ignored, so a
+ * replay survives the game crashing.
+ *
+ * Recording is switched on with --record <file>, and --replay <file> plays
+ * one back headless and as fast as possible (see playReplay in game.cpp).
+ * Only new games can be replayed, so the file is started over by each new
+ * game and recording stops if a saved game is loaded.
+ */
+
+#include <stdint.h>
+
+#define REPLAY_VERSION 2
+
+// Recording
+int startRecording( const char *path );
+bool recording();
+void recordSeed( uint64_t seed ); // Opens the file and writes the header
+void recordKey( unsigned long tick, int key, int command );
+void stopRecording();
+
+// Playback
+int openReplay( const char *path );
+bool replaying();
+uint64_t replaySeed();
+// false once the replay has run out
+bool nextReplayKey( unsigned long &tick, int &key, int &command );
+void closeReplay();
+
+#endif
@@ -1,4 +1,5 @@
 #include "structures.h"
+#include "pool.h"
 
 Location::Location() {
    ter = FLOOR;
@@ -7,6 +8,9 @@ Location::Location() {
 }
 
 Level::Level( int x, int y ) {
+   static int next_arena = PERSISTENT_ARENA + 1;
+   arena = next_arena++;
+
    x_dim = x;
    y_dim = y;
    map = new Location*[y_dim];
@@ -19,4 +23,20 @@ Level::Level( int x, int y ) {
       }
    }
    exits = 0;
+
+   suspended = false;
+   suspended_tick = 0;
+
+   grids_dirty = true;
+   fov_x = fov_y = fov_range = -1;
+}
+
+Level::~Level() {
+   for (unsigned int i = 0; i < y_dim; ++i) {
+      delete[] map[i];
+      delete[] vision_map[i];
+   }
+   delete[] map;
+   delete[] vision_map;
+   delete[] exits;
 }
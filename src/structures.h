@@ -1,6 +1,11 @@
 #ifndef STRUCTURES_H__
 #define STRUCTURES_H__
 
+#include <queue>
+#include <vector>
+
+#include "handle.h"
+
 struct Unit;
 struct Item;
 
@@ -43,12 +48,53 @@ struct Location {
 #define MAP_VISIBLE 0x1
 #define MAP_SEEN 0x4
 
+// Time
+
+// Units can die while they wait, so the queue holds handles
+struct UnitTime
+{
+   unsigned long tick; 
+   Handle unit;
+
+   UnitTime( unsigned long t, Handle u ) { tick = t; unit = u;}
+};
+
+struct TimeQueueComparator
+{
+   bool operator() (const UnitTime &lhs, const UnitTime &rhs) {
+      return lhs.tick > rhs.tick;
+   }
+};
+
+typedef std::priority_queue<UnitTime,std::vector<UnitTime>,TimeQueueComparator> TimeQueue;
+
+/* Each Level keeps its own queue of waiting units.  Only the current level's
+ * queue is run; a level the player leaves is suspended, and is brought up to
+ * date in one cheap pass (see catchUpLevel) when the player comes back.
+ */
+
+#define NUM_EXITS 8 // STAIRS_UP_1..4 are exits 0-3, STAIRS_DOWN_1..4 are 4-7
+
 struct Level {
    unsigned int x_dim, y_dim;
    Location **map;
    int **vision_map;
    Level* *exits; // Indexed array of exits (Level*)
 
+   int arena; // Pool arena for the units and items that belong here, see pool.h
+
+   TimeQueue time_queue;
+   bool suspended;
+   unsigned long suspended_tick; // value of 'ticks' when the player left
+
+   // The terrain and vision grids as last saved, reused until they change
+   std::vector<unsigned char> grid_cache;
+   bool grids_dirty;
+
+   // Where the vision map was last computed from; -1 to force a redo
+   int fov_x, fov_y, fov_range;
+
    Level( int x, int y );
+   ~Level();
 };
 #endif
@@ -3,7 +3,11 @@
 
 #include <string>
 
-void writeSystemLog( std::string text );
+// Text is prefixed with 'indent' copies of 'pad' and cut to the log width
+void writeSystemLog( const char *text, int indent=0, char pad=' ' );
+
+// Adds 'lines' lines for a combat event, formatted when they're drawn
+void writeSystemLogEvent( unsigned int event, int lines );
 
 #endif
 
@@ -4,52 +4,46 @@
 #include "structures.h"
 #include "items.h"
 #include "syslog.h"
+#include "pool.h"
+#include "random.h"
 
-#include <cstdlib>
-#include <sstream>
+#include <cstdio>
 
 #include <SFML/Graphics.hpp>
 
 Unit::Unit() {
-   display_char = '_';
-   alive = true;
+   handle = unitHandles().add( this );
+   unitComponents().attach( handle );
    chassis = NULL;
-   inventory = NULL;
-   pos_x = 0;
-   pos_y = 0;
-   move_speed = 1000;
-   vision_range = 5;
 }
 
 Unit::Unit( unsigned int d_c ) {
-   display_char = d_c;
-   alive = true;
+   handle = unitHandles().add( this );
+   unitComponents().attach( handle );
+   look().display_char = d_c;
    chassis = NULL;
-   inventory = NULL;
 }
 
-Unit::~Unit() { }
-
-void Unit::drawUnit( int x, int y ) {
-   writeChar( display_char, sf::Color::White, sf::Color::Black, x, y );
+Unit::~Unit()
+{
+   unitComponents().detach( handle );
+   unitHandles().remove( handle );
 }
 
 int Unit::meleeAttack( Unit *target ) {
-   Item *melee_stack = chassis->getAllMelee();
+   ItemSpan melee_stack = chassis->getAllMelee();
 
-   if (melee_stack == NULL)
+   if (melee_stack.empty())
       return -1;
 
-   std::stringstream txt1;
-   txt1 << ">I attack " << target->getName();
-   writeSystemLog( txt1.str() );
+   char txt1[64];
+   snprintf( txt1, sizeof(txt1), ">I attack %s", target->getName() );
+   writeSystemLog( txt1 );
 
-   while (melee_stack != NULL) {
-      int result = melee_stack->meleeAttack( target );
+   for (int i = 0; i < melee_stack.count; ++i) {
+      int result = melee_stack[i]->meleeAttack( this, target );
       if (result == 1) // Target destroyed
          break;
-
-      melee_stack = melee_stack->alt_next;
    }
    return 1000;
 }
@@ -63,55 +57,92 @@ int Unit::destroyEquipment( Item *to_destroy )
    return 0;
 }
 
-std::string Unit::getNamePadded( int num, char pad )
+// Off-screen units slowly patch up their chassis
+const unsigned long offscreen_repair_ticks = 100; // ticks per point of durability
+
+int Unit::catchUp( unsigned long elapsed )
+{
+   if (!body().alive)
+      return -1;
+
+   if (chassis != NULL) {
+      unsigned long repair = elapsed / offscreen_repair_ticks;
+      if (repair > (unsigned long) (chassis->def->max_durability - chassis->durability))
+         chassis->durability = chassis->def->max_durability;
+      else
+         chassis->durability += repair;
+   }
+
+   return 0;
+}
+
+void* Unit::operator new( size_t size )
 {
-   std::string padding( num, pad );
-   return padding + getName();
+   return unitPool().allocate( size );
+}
+
+void Unit::operator delete( void *p )
+{
+   ObjectPool::release( p );
 }
 
 AI::AI() {
-   display_char = 'z';
-   alive = true;
-   chassis = new BasicChassis();
-   inventory = NULL;
-   pos_x = 0;
-   pos_y = 0;
-   move_speed = 1000;
-   vision_range = 5;
+   look().display_char = 'z';
+   chassis = new Chassis( BASIC_CHASSIS );
 
-   behavior = WANDER;
-   onmyteam = false;
-   aggro = 0;
+   brain().behavior = WANDER;
 }
 
 AI::~AI() { }
 
-std::string AI::getName()
+const char* AI::getName()
 {
    return "AI Robot";
 }
 
-int AI::takeTurn() {
-   if (!alive)
+int aiTurn( unsigned int n, Unit *unit )
+{
+   UnitComponents &uc = unitComponents();
+   if (!uc.body[n].alive)
       return -1;
 
-   if (behavior == WANDER) {
-      int x = rand() % 8;
-      moveUnit( this, (Direction) x );
+   if (uc.brain[n].behavior == WANDER) {
+      int x = rng( AI_RNG ).below( 8 );
+      moveUnit( unit, (Direction) x );
    }
 
    return 1000;
-};
+}
+
+int AI::takeTurn() {
+   return aiTurn( handle.index, this );
+}
+
+// Wandering is summarised as a short random walk rather than every step
+const unsigned long max_catch_up_steps = 10;
+
+int AI::catchUp( unsigned long elapsed )
+{
+   if (!body().alive)
+      return -1;
+
+   int move_speed = body().move_speed;
+   if (brain().behavior == WANDER && move_speed > 0) {
+      unsigned long steps = elapsed / move_speed;
+      if (steps > max_catch_up_steps)
+         steps = max_catch_up_steps;
+
+      for (unsigned long s = 0; s < steps; ++s)
+         moveUnit( this, (Direction) rng( AI_RNG ).below( 8 ) );
+   }
+
+   return Unit::catchUp( elapsed );
+}
 
 Player::Player() {
-   display_char = '@';
-   alive = true;
-   chassis = NULL;
-   inventory = NULL;
-   pos_x = 0;
-   pos_y = 0;
-   move_speed = 700;
-   vision_range = 8;
+   look().display_char = '@';
+   body().move_speed = 700;
+   body().vision_range = 8;
 
    personal_name = "Robot Jones";
 }
@@ -122,7 +153,7 @@ int Player::takeTurn() {
    return 0; // I am the player
 }
 
-std::string Player::getName()
+const char* Player::getName()
 {
-   return personal_name;
+   return personal_name.c_str();
 }
@@ -2,58 +2,59 @@
 #define UNITS_H__
 
 #include "items.h"
+#include "inventory.h"
+#include "handle.h"
+#include "components.h"
 
 struct Unit
 {
-   unsigned int display_char;
+   Handle handle; // Hold on to this, not the pointer, across turns
 
-   bool alive;
-
-   int pos_x, pos_y;
-
-   int move_speed;
-   int vision_range;
+   // This unit's slots in unitComponents()
+   Position& pos() { return unitComponents().position[handle.index]; }
+   Body& body() { return unitComponents().body[handle.index]; }
+   Look& look() { return unitComponents().look[handle.index]; }
 
    Chassis *chassis;
-   Item *inventory;
+   Inventory inventory;
 
    Unit();
    Unit( unsigned int d_c );
    virtual ~Unit();
 
-   void drawUnit( int x, int y );
-
    int meleeAttack( Unit *target );
    //int rangedAttack( Unit *target );
 
    int destroyEquipment( Item *to_destroy );
 
    virtual int takeTurn() = 0;
-   virtual std::string getName() = 0;
-   std::string getNamePadded( int num=1, char pad=' ' );
-};
+   // Summarised version of 'elapsed' ticks of turns, for suspended levels
+   virtual int catchUp( unsigned long elapsed );
+   virtual const char* getName() = 0;
 
-enum AIBehavior {
-   IDLE,
-   WANDER,
-   PATROL,
-   ATTACK_ENEMIES,
-   RUN_FROM_ENEMIES
+   // Units live in unitPool() - see pool.h
+   static void* operator new( size_t size );
+   static void operator delete( void *p );
 };
 
 struct AI : public Unit
 {
-   AIBehavior behavior;
-   bool onmyteam;
-   int aggro;
+   Brain& brain() { return unitComponents().brain[handle.index]; }
 
    AI();
    virtual ~AI();
 
    virtual int takeTurn();
-   virtual std::string getName();
+   virtual int catchUp( unsigned long elapsed );
+   virtual const char* getName();
 };
 
+/* One AI turn, read straight from slot n of the component arrays.  The Unit
+ * is only needed to move it on the map.  -1 if the unit is dead, otherwise
+ * the time taken.
+ */
+int aiTurn( unsigned int n, Unit *unit );
+
 struct Player : public Unit
 {
    std::string personal_name;
@@ -62,7 +63,7 @@ struct Player : public Unit
    virtual ~Player();
 
    virtual int takeTurn();
-   virtual std::string getName();
+   virtual const char* getName();
 };
 
 #endif